@@ -1,5 +1,5 @@
 TEMPLATE = app
-CONFIG += console c++17
+CONFIG += console c++17 thread
 CONFIG -= app_bundle
 CONFIG -= qt
 
@@ -9,7 +9,8 @@
 
 #include "modules.hpp"
 
-#include <vector>
+#include <cstdint>
+#include <initializer_list>
 
 
 //======================================================================================================================
@@ -83,13 +84,40 @@ static const char * EngineerNameStr [] =
 
 static_assert( size_t(EngineerIdx::_EndOfEnum) == std::size(EngineerNameStr), "string table and enum do not match" );
 
+/// set of engineers stored as bits of a single word, bit N represents the engineer with EngineerIdx N
+using EngineerMask = uint32_t;
+
+static_assert( size_t(EngineerIdx::_EndOfEnum) <= 8 * sizeof(EngineerMask), "engineers don't fit into the mask" );
+
 
 //======================================================================================================================
 
+static constexpr size_t maxOffersPerEngineer = 12;
+
+/// Fixed-capacity list of modifications offered by one engineer, usable at compile time.
+class OfferedModifications
+{
+	size_t count = 0;
+	Modification array [ maxOffersPerEngineer ] {};
+
+ public:
+
+	constexpr OfferedModifications() = default;
+	constexpr OfferedModifications( std::initializer_list< Modification > mods )
+	{
+		for (const Modification & mod : mods)
+			array[ count++ ] = mod;
+	}
+
+	constexpr const Modification * begin() const  { return array; }
+	constexpr const Modification * end() const    { return array + count; }
+	constexpr size_t size() const                 { return count; }
+};
+
 struct EngineerInfo
 {
 	EngineerIdx requiredEngineer;
-	std::vector< Modification > modifications;
+	OfferedModifications modifications;
 };
 
 struct Engineer
@@ -98,7 +126,7 @@ struct Engineer
 	EngineerInfo info;
 };
 
-static const Engineer _engineers [] =
+static constexpr Engineer _engineers [] =
 {
 	{ None, { None, {} } },  // first engineer has index 1 so we have to put a placeholder here
 
@@ -473,21 +501,84 @@ static const Engineer _engineers [] =
 
 
 //----------------------------------------------------------------------------------------------------------------------
-//  Thanks GCC for still not supporting designated array initializers
-//  and thanks mingw64-clang for not linking standard library stuff properly.
+//  The whole database, including everything derived from it, is computed by the compiler,
+//  so the application startup doesn't have to allocate or initialize anything.
+
+static constexpr size_t numOfEngineerSlots = std::size(_engineers);
+static constexpr size_t numOfModules = size_t(ModuleType::_EndOfEnum);
 
-static EngineerInfo engineers [ std::size(_engineers) ];
+/// the number of modules rounded up to whole 32-byte SIMD registers
+static constexpr size_t gradeVectorSize = (numOfModules + 31) / 32 * 32;
+
+struct EngineerDatabase
+{
+	/// the table above, but indexed by EngineerIdx
+	EngineerInfo engineers [ numOfEngineerSlots ];
+
+	/// For each engineer, all the engineers that are required to be unlocked to unlock him, including the engineer himself.
+	EngineerMask requirementClosures [ numOfEngineerSlots ];
+	/// number of engineers in each of the requirementClosures
+	uint requirementClosureSizes [ numOfEngineerSlots ];
+
+	/// the highest grade each engineer offers for each module, 0 if he doesn't offer the module at all
+	grade_t offeredGrades [ numOfEngineerSlots ][ numOfModules ];
+	/// the same as offeredGrades, but one byte per module and padded with zeros, so that it can be processed by SIMD
+	uint8_t offeredGradeVectors [ numOfEngineerSlots ][ gradeVectorSize ];
+
+	/// Inverted index of the engineer database: for each module and grade, all engineers offering at least that grade.
+	EngineerMask engineersOfferingGrade [ numOfModules ][ maxGrade + 1 ];
+};
 
-bool initializeEngineers()
+constexpr EngineerDatabase buildEngineerDatabase()
 {
+	EngineerDatabase db {};
+
+	//  Thanks GCC for still not supporting designated array initializers.
+	for (const auto & engineer : _engineers)
+	{
+		db.engineers[ engineer.idx ] = engineer.info;
+	}
+
+	// walk the chains of required engineers once here, so that the algorithm doesn't have to do it over and over
+	for (const auto & engineer : _engineers)
+	{
+		EngineerMask closure = 0;
+		uint closureSize = 0;
+		for (EngineerIdx currentIdx = engineer.idx; currentIdx != EngineerIdx::None; currentIdx = db.engineers[ currentIdx ].requiredEngineer)
+		{
+			closure |= EngineerMask(1) << currentIdx;
+			closureSize += 1;
+		}
+		db.requirementClosures[ engineer.idx ] = closure;
+		db.requirementClosureSizes[ engineer.idx ] = closureSize;
+	}
+
 	for (const auto & engineer : _engineers)
 	{
-		engineers[ engineer.idx ] = engineer.info;
+		for (const auto & mod : engineer.info.modifications)
+		{
+			db.offeredGrades[ engineer.idx ][ size_t(mod.module) ] = mod.grade;
+			db.offeredGradeVectors[ engineer.idx ][ size_t(mod.module) ] = uint8_t( mod.grade );
+
+			// an engineer offering some grade also offers all the lower grades
+			for (grade_t grade = 0; grade <= mod.grade; ++grade)
+			{
+				db.engineersOfferingGrade[ size_t(mod.module) ][ grade ] |= EngineerMask(1) << engineer.idx;
+			}
+		}
 	}
-	return true;
+
+	return db;
 }
-// This will cause the function to be called right on the application startup, even before main is entered.
-static const bool engineerInitializer = initializeEngineers();
+
+static constexpr EngineerDatabase engineerDatabase = buildEngineerDatabase();
+
+static constexpr const auto & engineers = engineerDatabase.engineers;
+static constexpr const auto & requirementClosures = engineerDatabase.requirementClosures;
+static constexpr const auto & requirementClosureSizes = engineerDatabase.requirementClosureSizes;
+static constexpr const auto & offeredGrades = engineerDatabase.offeredGrades;
+static constexpr const auto & offeredGradeVectors = engineerDatabase.offeredGradeVectors;
+static constexpr const auto & engineersOfferingGrade = engineerDatabase.engineersOfferingGrade;
 
 
 #endif // ENGINEERS_INCLUDED
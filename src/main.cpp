@@ -23,6 +23,7 @@
 	using std::istringstream;
 #include <fstream>
 	using std::ifstream;
+	using std::ofstream;
 #include <iomanip>
 #include <cctype>  // isdigit, isspace
 #include <string>
@@ -37,8 +38,15 @@
 #include <unordered_map>
 	using std::unordered_map;
 	using std::unordered_multimap;
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
 #include <cerrno>
 #include <cstring>  // strerror
+#include <cstdio>  // rename
+#include <cstdlib>  // strtoull
 
 
 //======================================================================================================================
@@ -156,56 +164,233 @@ class FixedList
 
 
 //----------------------------------------------------------------------------------------------------------------------
-/// Fast unordered set for index-like elements, using plain array for storage,
-/// that remembers how many times a value was inserted and erasing it erases just one occurence.
+//  bit manipulation
+
+#ifdef __GNUC__
+inline uint popCount( uint32_t word )            { return uint( __builtin_popcount( word ) ); }
+inline uint popCount( uint64_t word )            { return uint( __builtin_popcountll( word ) ); }
+inline uint countTrailingZeros( uint32_t word )  { return uint( __builtin_ctz( word ) ); }
+inline uint countTrailingZeros( uint64_t word )  { return uint( __builtin_ctzll( word ) ); }
+#else
+template< typename Word >
+uint popCount( Word word )
+{
+	uint count = 0;
+	for (; word != 0; word &= word - 1)
+		count += 1;
+	return count;
+}
+template< typename Word >
+uint countTrailingZeros( Word word )
+{
+	uint count = 0;
+	for (; (word & 1) == 0; word >>= 1)
+		count += 1;
+	return count;
+}
+#endif
+
+
+//----------------------------------------------------------------------------------------------------------------------
+//  SIMD kernels
 //
-//  A std::unordered_multiset isn't enough because one call to erase() erases all occurences
-//  and iteration visits all multiplicated entries as many times as they are there.
+//  Checking what a set of engineers offers is a comparison of the grades of all modules at once, which fits into one
+//  or two SIMD registers, and the sizes of many engineer sets can be computed at once too. Each operation has
+//  a portable scalar version and an AVX2 version, the AVX2 one is used only if the CPU running the program supports it.
 //
-//  We need the iteration to behave just like it was a standard set and erase() to just decrease the count,
-//  in order to be able to restore the set to its previous state, before a batch of items was inserted.
+//  Grade vectors have one byte per module and gradeVectorSize bytes in total. Packed grade vectors have 4 bits
+//  per module, the grade of the even module in the low bits, and must be readable up to 32 bytes from their start.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define HAS_AVX2_KERNELS
+	#include <immintrin.h>
+#endif
+
+static constexpr size_t packedGradeVectorSize = (numOfModules + 1) / 2;
+static_assert( gradeVectorSize <= 64, "the result of modulesExceeding() would not fit" );
+static_assert( packedGradeVectorSize <= 32, "packed grade vectors must fit into a single register" );
+
+/// Sets the grades of the modules that are 0 in \p offered to the grades in \p engineerGrades.
+void mergeFirstOffers_scalar( uint8_t * offered, const uint8_t * engineerGrades )
+{
+	for (size_t i = 0; i < gradeVectorSize; ++i)
+		if (offered[i] == 0)
+			offered[i] = engineerGrades[i];
+}
+
+/// Returns bit mask of modules, whose grade in \p offered is higher than in \p wanted.
+uint64_t modulesExceeding_scalar( const uint8_t * offered, const uint8_t * wanted )
+{
+	uint64_t modules = 0;
+	for (size_t i = 0; i < gradeVectorSize; ++i)
+		if (offered[i] > wanted[i])
+			modules |= uint64_t(1) << i;
+	return modules;
+}
+
+/// Returns the index of the first of the packed grade vectors between \p begin and \p end that has all grades
+/// at least as high as the packed \p wanted vector, or \p end if there is none.
+size_t findFirstOffering_scalar( const uint8_t * packedVectors, size_t stride, size_t begin, size_t end, const uint8_t * wanted )
+{
+	for (size_t idx = begin; idx < end; ++idx)
+	{
+		const uint8_t * grades = packedVectors + idx * stride;
+		size_t i = 0;
+		while (i < packedGradeVectorSize && (grades[i] & 0x0F) >= (wanted[i] & 0x0F) && (grades[i] & 0xF0) >= (wanted[i] & 0xF0))
+			++i;
+		if (i == packedGradeVectorSize)
+			return idx;
+	}
+	return end;
+}
+
+/// Computes the number of bits in the union of \p base with each of the \p masks.
+void unionSizes_scalar( const uint32_t * masks, size_t count, uint32_t base, uint32_t * sizes )
+{
+	for (size_t i = 0; i < count; ++i)
+		sizes[i] = popCount( uint32_t( masks[i] | base ) );
+}
+
+#ifdef HAS_AVX2_KERNELS
+
+__attribute__(( target("avx2") ))
+void unionSizes_avx2( const uint32_t * masks, size_t count, uint32_t base, uint32_t * sizes )
+{
+	// AVX2 has no popcount instruction, so the bits of each nibble are counted by a table lookup, and the counts
+	// of the bytes are then summed within each 32-bit lane
+	const __m256i nibbleBitCounts = _mm256_setr_epi8(
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+	);
+	const __m256i lowNibbles = _mm256_set1_epi8( 0x0F );
+	const __m256i baseMask = _mm256_set1_epi32( int( base ) );
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i unions = _mm256_or_si256( _mm256_loadu_si256( reinterpret_cast< const __m256i * >( masks + i ) ), baseMask );
+		__m256i lowCounts = _mm256_shuffle_epi8( nibbleBitCounts, _mm256_and_si256( unions, lowNibbles ) );
+		__m256i highCounts = _mm256_shuffle_epi8( nibbleBitCounts, _mm256_and_si256( _mm256_srli_epi16( unions, 4 ), lowNibbles ) );
+		__m256i byteCounts = _mm256_add_epi8( lowCounts, highCounts );
+		__m256i pairCounts = _mm256_maddubs_epi16( byteCounts, _mm256_set1_epi8( 1 ) );
+		__m256i laneCounts = _mm256_madd_epi16( pairCounts, _mm256_set1_epi16( 1 ) );
+		_mm256_storeu_si256( reinterpret_cast< __m256i * >( sizes + i ), laneCounts );
+	}
+	unionSizes_scalar( masks + i, count - i, base, sizes + i );
+}
+
+__attribute__(( target("avx2") ))
+void mergeFirstOffers_avx2( uint8_t * offered, const uint8_t * engineerGrades )
+{
+	for (size_t i = 0; i < gradeVectorSize; i += 32)
+	{
+		__m256i current = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( offered + i ) );
+		__m256i added = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( engineerGrades + i ) );
+		__m256i isEmpty = _mm256_cmpeq_epi8( current, _mm256_setzero_si256() );
+		_mm256_storeu_si256( reinterpret_cast< __m256i * >( offered + i ), _mm256_blendv_epi8( current, added, isEmpty ) );
+	}
+}
+
+__attribute__(( target("avx2") ))
+uint64_t modulesExceeding_avx2( const uint8_t * offered, const uint8_t * wanted )
+{
+	uint64_t modules = 0;
+	for (size_t i = 0; i < gradeVectorSize; i += 32)
+	{
+		__m256i offeredGrades = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( offered + i ) );
+		__m256i wantedGrades = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( wanted + i ) );
+		// there is no unsigned greater-than, but offered <= wanted exactly when max( offered, wanted ) == wanted
+		__m256i notExceeding = _mm256_cmpeq_epi8( _mm256_max_epu8( offeredGrades, wantedGrades ), wantedGrades );
+		modules |= uint64_t( ~uint32_t( _mm256_movemask_epi8( notExceeding ) ) ) << i;
+	}
+	return modules;
+}
+
+__attribute__(( target("avx2") ))
+size_t findFirstOffering_avx2( const uint8_t * packedVectors, size_t stride, size_t begin, size_t end, const uint8_t * wanted )
+{
+	// the bytes of the wanted vector after the last module are 0, so whatever is loaded there passes
+	const __m256i lowNibbles = _mm256_set1_epi8( 0x0F );
+	const __m256i wantedPacked = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( wanted ) );
+	const __m256i wantedLow = _mm256_and_si256( wantedPacked, lowNibbles );
+	const __m256i wantedHigh = _mm256_and_si256( _mm256_srli_epi16( wantedPacked, 4 ), lowNibbles );
+	for (size_t idx = begin; idx < end; ++idx)
+	{
+		__m256i grades = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( packedVectors + idx * stride ) );
+		__m256i low = _mm256_and_si256( grades, lowNibbles );
+		__m256i high = _mm256_and_si256( _mm256_srli_epi16( grades, 4 ), lowNibbles );
+		__m256i lowOk = _mm256_cmpeq_epi8( _mm256_max_epu8( low, wantedLow ), low );
+		__m256i highOk = _mm256_cmpeq_epi8( _mm256_max_epu8( high, wantedHigh ), high );
+		if (uint32_t( _mm256_movemask_epi8( _mm256_and_si256( lowOk, highOk ) ) ) == 0xFFFFFFFFu)
+			return idx;
+	}
+	return end;
+}
+
+#endif // HAS_AVX2_KERNELS
+
+/// the implementations of the grade vector operations chosen for the current CPU
+struct SimdKernels
+{
+	void (* mergeFirstOffers)( uint8_t * offered, const uint8_t * engineerGrades );
+	uint64_t (* modulesExceeding)( const uint8_t * offered, const uint8_t * wanted );
+	size_t (* findFirstOffering)( const uint8_t * packedVectors, size_t stride, size_t begin, size_t end, const uint8_t * wanted );
+	void (* unionSizes)( const uint32_t * masks, size_t count, uint32_t base, uint32_t * sizes );
+};
+
+const SimdKernels & simdKernels()
+{
+	static const SimdKernels kernels = []
+	{
+	 #ifdef HAS_AVX2_KERNELS
+		if (__builtin_cpu_supports( "avx2" ))
+			return SimdKernels{ mergeFirstOffers_avx2, modulesExceeding_avx2, findFirstOffering_avx2, unionSizes_avx2 };
+	 #endif
+		return SimdKernels{ mergeFirstOffers_scalar, modulesExceeding_scalar, findFirstOffering_scalar, unionSizes_scalar };
+	}();
+	return kernels;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/// Fast unordered set for index-like elements, using a single machine word for storage.
 //
-//  We could just use simple C array or std::array directly and don't bother with this class,
-//  but this way we can at least give it some prettier interface.
+//  Every index is represented by one bit, so size() is just a popcount and the iteration jumps directly
+//  to the next present index using count-trailing-zeros, instead of visiting every possible index.
 template< typename Index, Index endIndex >
-class CountedIndexSet
+class IndexBitSet
 {
+	static_assert( size_t(endIndex) <= 64, "the indexes must fit into a single 64-bit word" );
+
+ public:
+
+	using Word = std::conditional_t< size_t(endIndex) <= 32, uint32_t, uint64_t >;
+
  protected:
 
-	// The count has signed so that it remembers when we try to delete an element that wasn't there,
-	// and cancels out with trying to re-add it later.
-	int array [ size_t(endIndex) ] {};  // initialize all indexes to 0
+	Word bits = 0;
+
+	static Word bit( Index idx ) { return Word(1) << size_t(idx); }
 
 	class Iterator
 	{
-		const int * array;
-		Index currentIdx;
+		Word remaining;  ///< bits that haven't been visited yet
 
 	 public:
 
 		// required for std::lexicographical_compare to work
 		using difference_type = std::ptrdiff_t;
 		using value_type = Index;
-		using pointer = value_type *;
-		using reference = value_type &;
+		using pointer = const value_type *;
+		using reference = value_type;
 		using iterator_category = std::forward_iterator_tag;
 
-		Iterator( const int * array, Index startingIdx ) : array( array )
-		{
-			// move the current index to the nearest index that is present
-			currentIdx = startingIdx;
-			while (currentIdx < endIndex && array[ size_t(currentIdx) ] <= 0)
-				currentIdx = inc( currentIdx );
-		}
+		Iterator( Word bits ) : remaining( bits ) {}
 
-		auto operator*() const { return currentIdx; }
-		auto operator->() const { return &currentIdx; }
+		Index operator*() const { return Index( countTrailingZeros( remaining ) ); }
 
 		Iterator & operator++()
 		{
-			do
-				currentIdx = inc( currentIdx );
-			while (currentIdx < endIndex && array[ size_t(currentIdx) ] <= 0);
+			remaining &= remaining - 1;  // clear the lowest set bit
 			return *this;
 		}
 		Iterator operator++(int)
@@ -215,54 +400,42 @@ class CountedIndexSet
 			return previous;
 		}
 
-		friend bool operator==( const Iterator & a, const Iterator & b )
-		{
-			return a.array + a.currentIdx == b.array + b.currentIdx;
-		}
-		friend bool operator!=( const Iterator & a, const Iterator & b )
-		{
-			return a.array + a.currentIdx != b.array + b.currentIdx;
-		}
+		friend bool operator==( const Iterator & a, const Iterator & b ) { return a.remaining == b.remaining; }
+		friend bool operator!=( const Iterator & a, const Iterator & b ) { return a.remaining != b.remaining; }
 	};
 
  public:
 
-	CountedIndexSet() = default;
-	CountedIndexSet( const CountedIndexSet< Index, endIndex > & other ) = default;
-	CountedIndexSet< Index, endIndex > & operator=( const CountedIndexSet< Index, endIndex > & other ) = default;
+	IndexBitSet() = default;
+	explicit IndexBitSet( Word bits ) : bits( bits ) {}
 
-	void insert( Index idx )
-	{
-		array[ size_t(idx) ] += 1;
-	}
+	void insert( Index idx )              { bits |= bit( idx ); }
+	void erase( Index idx )               { bits &= ~bit( idx ); }
+	bool contains( Index idx ) const      { return (bits & bit( idx )) != 0; }
 
-	void erase( Index idx )
-	{
-		array[ size_t(idx) ] -= 1;
-	}
+	size_t size() const                   { return popCount( bits ); }
+	bool empty() const                    { return bits == 0; }
 
-	bool contains( Index idx ) const
-	{
-		return array[ size_t(idx) ] > 0;
-	}
+	Word mask() const                     { return bits; }
 
-	size_t size() const
-	{
-		// This is not called very often and the size of the array is in decades only, so we can afford to be linear.
-		size_t size = 0;
-		for (size_t idx = 0; idx < size_t(endIndex); ++idx)
-			size += size_t( array[ idx ] > 0 );  // we're using bool as int, true is guaranteed to convert to 1
-		return size;
-	}
+	bool isSubsetOf( const IndexBitSet & other ) const    { return (bits & ~other.bits) == 0; }
 
-	bool empty() const
-	{
-		return size() == 0;
-	}
+	/// inserts all elements of the other set
+	IndexBitSet & operator|=( const IndexBitSet & other ) { bits |= other.bits; return *this; }
+
+	/// union
+	friend IndexBitSet operator|( const IndexBitSet & a, const IndexBitSet & b ) { return IndexBitSet( a.bits | b.bits ); }
+	/// intersection
+	friend IndexBitSet operator&( const IndexBitSet & a, const IndexBitSet & b ) { return IndexBitSet( a.bits & b.bits ); }
+	/// difference
+	friend IndexBitSet operator-( const IndexBitSet & a, const IndexBitSet & b ) { return IndexBitSet( a.bits & ~b.bits ); }
+
+	friend bool operator==( const IndexBitSet & a, const IndexBitSet & b ) { return a.bits == b.bits; }
+	friend bool operator!=( const IndexBitSet & a, const IndexBitSet & b ) { return a.bits != b.bits; }
 
 	using const_iterator = Iterator;
-	const_iterator begin() const { return const_iterator( array, Index(0) ); }
-	const_iterator end() const   { return const_iterator( array, endIndex ); }
+	const_iterator begin() const { return const_iterator( bits ); }
+	const_iterator end() const   { return const_iterator( 0 ); }
 };
 
 
@@ -303,9 +476,68 @@ class IndexMultimap
 		array[ size_t(idx) ].push_back( val );
 	}
 
-	void erase( Index idx, const Value & val )
+};
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/// Undo log for backtracking algorithms.
+//
+//  Every modification of the state that needs to be restored later is done via assign(), which first records
+//  the address and the previous value of the modified variable. Backtracking to a previously taken mark then pops
+//  the records and writes the previous values back, so the cost of the undo is proportional to what actually changed,
+//  not to the size of the whole state.
+class UndoTrail
+{
+	struct Entry
+	{
+		void * address;
+		uint64_t previousValue;
+		size_t size;
+	};
+	vector< Entry > entries;
+
+ public:
+
+	using Mark = size_t;
+
+	void reserve( size_t numOfEntries )  { entries.reserve( numOfEntries ); }
+
+	/// position in the trail, to which the state can be later restored
+	Mark mark() const  { return entries.size(); }
+
+	template< typename Word >
+	void assign( Word & variable, const Word & newValue )
+	{
+		static_assert( std::is_trivially_copyable_v< Word > && sizeof(Word) <= sizeof(uint64_t), "unsupported type" );
+
+		if (variable == newValue)
+			return;  // nothing to be restored later
+
+		Entry entry;
+		entry.address = &variable;
+		entry.size = sizeof(Word);
+		memcpy( &entry.previousValue, &variable, sizeof(Word) );
+		entries.push_back( entry );
+
+		variable = newValue;
+	}
+
+	/// Restores all variables assigned since the mark was taken to their previous values.
+	void undoTo( Mark mark )
 	{
-		array[ size_t(idx) ].remove( val );
+		while (entries.size() > mark)
+		{
+			const Entry & entry = entries.back();
+			switch (entry.size)  // constant sizes allow the compiler to replace memcpy with a single move
+			{
+				case 1:  memcpy( entry.address, &entry.previousValue, 1 ); break;
+				case 2:  memcpy( entry.address, &entry.previousValue, 2 ); break;
+				case 4:  memcpy( entry.address, &entry.previousValue, 4 ); break;
+				case 8:  memcpy( entry.address, &entry.previousValue, 8 ); break;
+				default: memcpy( entry.address, &entry.previousValue, entry.size ); break;
+			}
+			entries.pop_back();
+		}
 	}
 };
 
@@ -314,26 +546,20 @@ class IndexMultimap
 //  algorithm
 
 using EngineerList = FixedList< EngineerIdx, numOfEngineers >;
-using EngineerSet = CountedIndexSet< EngineerIdx, EngineerIdx::_EndOfEnum >;
+using EngineerSet = IndexBitSet< EngineerIdx, EngineerIdx::_EndOfEnum >;
+
+static_assert( std::is_same_v< EngineerSet::Word, EngineerMask >, "EngineerSet must be compatible with EngineerMask" );
+
+/// All engineers that are required to be unlocked to unlock this engineer, including this engineer himself.
+EngineerSet requirementsOf( EngineerIdx engineerIdx )
+{
+	return EngineerSet( requirementClosures[ engineerIdx ] );
+}
 
 /// Finds all engineers that offer modification of specified grade to a specified module.
 EngineerSet findEngineersOfferingModification( Modification desiredMod )
 {
-	EngineerSet selectedEngineers;
-
-	for (EngineerIdx engineerIdx = firstEngineerIdx; engineerIdx <= lastEngineerIdx; engineerIdx = EngineerIdx( engineerIdx + 1 ))
-	{
-		auto & offeredMods = engineers[ engineerIdx ].modifications;
-
-		if (containsSuch( offeredMods, [ &desiredMod ]( const Modification & offeredMod ) {
-			return offeredMod.module == desiredMod.module && offeredMod.grade >= desiredMod.grade;
-		}))
-		{
-			selectedEngineers.insert( EngineerIdx(engineerIdx) );
-		}
-	}
-
-	return selectedEngineers;
+	return EngineerSet( engineersOfferingGrade[ size_t(desiredMod.module) ][ desiredMod.grade ] );
 }
 
 
@@ -357,181 +583,2452 @@ struct DesiredModContext
 	EngineerSet engineers;  ///< engineers offering this mod
 };
 
-struct Solution
+/// comparator for sorting the solutions, orders sets of engineers lexicographically
+bool operator<( const EngineerSet & engineers1, const EngineerSet & engineers2 )
+{
+	return std::lexicographical_compare( engineers1.begin(), engineers1.end(), engineers2.begin(), engineers2.end() );
+}
+
+/// orders sets of engineers by their size first, and only the sets of the same size lexicographically
+struct SmallerEngineerSet
+{
+	bool operator()( const EngineerSet & engineers1, const EngineerSet & engineers2 ) const
+	{
+		if (engineers1.size() != engineers2.size())
+			return engineers1.size() < engineers2.size();
+		return engineers1 < engineers2;
+	}
+};
+
+/// Flat storage of solutions in a compact form, that prevents duplicating solutions with the same set of engineers.
+//
+//  Each solution is stored only as its set of engineers, in a continuous array shared by all solutions,
+//  so adding a solution is just appending a word. The engineer chosen for each desired mod is not stored,
+//  the output reconstructs it from the set, see assignModsToEngineers().
+//  Duplicates are detected by an open-addressing hash table over the sets of engineers.
+class SolutionPool
+{
+	vector< EngineerSet > engineerSets;  ///< set of engineers required to be unlocked, one per solution
+
+	vector< uint32_t > hashTable;  ///< index of a solution + 1, or 0 for an empty slot
+	uint hashShift = 32;  ///< how many bits of the hash to discard so that it fits the size of the table
+
+	static constexpr size_t initialTableSize = 64;
+
+	size_t slotOf( EngineerSet engineerSet ) const
+	{
+		// Fibonacci hashing, the high bits of the product are well mixed
+		return size_t( uint32_t( engineerSet.mask() * 0x9E3779B1u ) >> hashShift );
+	}
+
+	/// returns the slot where the set of engineers is, or where it should be inserted
+	size_t findSlot( EngineerSet engineerSet ) const
+	{
+		size_t slot = slotOf( engineerSet );
+		while (hashTable[ slot ] != 0 && engineerSets[ hashTable[ slot ] - 1 ] != engineerSet)
+			slot = (slot + 1) & (hashTable.size() - 1);
+		return slot;
+	}
+
+	void rebuildHashTable( size_t tableSize )
+	{
+		hashTable.assign( tableSize, 0 );
+		hashShift = 32 - popCount( uint32_t( tableSize - 1 ) );
+		for (size_t idx = 0; idx < engineerSets.size(); ++idx)
+			hashTable[ findSlot( engineerSets[ idx ] ) ] = uint32_t( idx + 1 );
+	}
+
+ public:
+
+	size_t size() const  { return engineerSets.size(); }
+	bool empty() const   { return engineerSets.empty(); }
+
+	const EngineerSet & engineers( size_t idx ) const  { return engineerSets[ idx ]; }
+
+	bool contains( EngineerSet engineerSet ) const
+	{
+		return !hashTable.empty() && hashTable[ findSlot( engineerSet ) ] != 0;
+	}
+
+	/// Returns false if a solution with the same set of engineers is already there.
+	bool insert( EngineerSet engineerSet )
+	{
+		// keep the load factor under 1/2, so that the chains of occupied slots stay short
+		if (2 * (engineerSets.size() + 1) > hashTable.size())
+			rebuildHashTable( std::max( 2 * hashTable.size(), initialTableSize ) );
+
+		size_t slot = findSlot( engineerSet );
+		if (hashTable[ slot ] != 0)
+			return false;
+
+		engineerSets.push_back( engineerSet );
+		hashTable[ slot ] = uint32_t( engineerSets.size() );
+		return true;
+	}
+
+	void clear()
+	{
+		engineerSets.clear();
+		std::fill( hashTable.begin(), hashTable.end(), 0 );
+	}
+
+	/// Orders the solutions by the sizes of their sets of engineers, and then lexicographically.
+	void sort()
+	{
+		std::sort( engineerSets.begin(), engineerSets.end(), SmallerEngineerSet() );
+		rebuildHashTable( hashTable.size() );
+	}
+};
+
+/// Remembers the states of the search that were already explored, in a fixed amount of memory.
+/** Each bucket has two entries, one is replaced only by states closer to the root of the recursion, whose subtrees are
+  * bigger, the other one always holds the most recent state. So the table can forget a state, but that only means
+  * it will be explored again. */
+class TranspositionTable
+{
+ public:
+
+	struct Key
+	{
+		EngineerSet requiredEngineers;
+		EngineerSet pinnedEngineers;
+		uint64_t decidedPinnedMods;  ///< one bit per pinned mod
+
+		bool operator==( const Key & other ) const
+		{
+			return requiredEngineers == other.requiredEngineers && pinnedEngineers == other.pinnedEngineers
+			    && decidedPinnedMods == other.decidedPinnedMods;
+		}
+	};
+
+ private:
+
+	struct Entry
+	{
+		Key key;
+		uint depth = 0;  ///< recursion depth of the state + 1, or 0 for an empty entry
+	};
+	struct Bucket
+	{
+		Entry preferred;  ///< the state closest to the root
+		Entry recent;  ///< the last inserted state
+	};
+	vector< Bucket > buckets;
+	uint hashShift = 64;
+
+	const Bucket & bucketOf( const Key & key ) const
+	{
+		uint64_t hash = uint64_t( key.requiredEngineers.mask() ) * 0x9E3779B97F4A7C15u
+		              ^ uint64_t( key.pinnedEngineers.mask() ) * 0xC2B2AE3D27D4EB4Fu
+		              ^ key.decidedPinnedMods * 0x165667B19E3779F9u;
+		return buckets[ size_t( (hash * 0x9E3779B97F4A7C15u) >> hashShift ) ];
+	}
+	Bucket & bucketOf( const Key & key )
+	{
+		return const_cast< Bucket & >( std::as_const( *this ).bucketOf( key ) );
+	}
+
+ public:
+
+	TranspositionTable() = default;
+	/// the number of buckets is rounded down to a power of 2
+	explicit TranspositionTable( size_t maxBuckets )
+	{
+		uint bits = 0;
+		while ((size_t(2) << bits) <= maxBuckets)
+			bits += 1;
+		buckets.resize( size_t(1) << bits );
+		hashShift = 64 - bits;
+	}
+
+	bool contains( const Key & key ) const
+	{
+		if (buckets.empty())
+			return false;
+		const Bucket & bucket = bucketOf( key );
+		return (bucket.preferred.depth != 0 && bucket.preferred.key == key)
+		    || (bucket.recent.depth != 0 && bucket.recent.key == key);
+	}
+
+	void insert( const Key & key, uint depth )
+	{
+		if (buckets.empty())
+			return;
+		Bucket & bucket = bucketOf( key );
+		if (bucket.preferred.depth == 0 || depth + 1 <= bucket.preferred.depth)
+			bucket.preferred = { key, depth + 1 };
+		else
+			bucket.recent = { key, depth + 1 };
+	}
+};
+
+/// state of the search, that is modified on the way down the recursion and restored on the way back
+struct SearchState
 {
 	/// set of engineers required to be unlocked
-	/** This must be a counted-set, so that we can easily restore the set to its previous state just by erasing the same
-	  * elements we inserted before. */
 	EngineerSet requiredEngineers;
 
-	/// which engineer was added for which modification
-	/** Key is the engineer, value is the list of modifications for which he was choses by the algorithm.
-	  * It could be part of the set above, but then it would be problematic to restore the set to its previous state. */
-	EngineerModMultimap relatedModifications;
+	/// engineers that are already used for pinning a modification, only one modification per engineer can be pinned
+	EngineerSet pinnedEngineers;
+
+	/// A different engineer for every pinned mod, indexed the same way as the DesiredModContexts.
+	/** For the decided mods it's the engineer pinning them, for the undecided ones it's an engineer that isn't pinning
+	  * anything yet. As long as such matching exists, all the pinned mods can still be satisfied. */
+	vector< EngineerIdx > pinMatching;
+
+	/// index of the pinned mod each engineer is matched to + 1, or 0 if he isn't matched, inverse of pinMatching
+	IndexMap< EngineerIdx, EngineerIdx::_EndOfEnum, size_t > matchedMod;
+
+	/// which of the pinned mods are decided, the bits are assigned by AlgorithmContext::pinnedModBits
+	uint64_t decidedPinnedMods = 0;
 };
 
-/// comparator for the set below, prevents duplicating solutions with the same set of engineers
-bool operator<( const Solution & solution1, const Solution & solution2 )
+/// engineers that can replace each other in any solution of the current request
+/** They have the same requirements, offer the same of the requested modifications, and none of the other candidates
+  * requires them. The search uses only the first few of them, and the solutions with the rest are derived afterwards. */
+struct InterchangeableEngineers
 {
-	return std::lexicographical_compare(
-		solution1.requiredEngineers.begin(), solution1.requiredEngineers.end(),
-		solution2.requiredEngineers.begin(), solution2.requiredEngineers.end()
-	);
+	EngineerSet members;  ///< all engineers of the group
+	EngineerSet searched;  ///< the first members, as many as can be needed in one solution
+};
+
+/// Replaces the members of each interchangeable group by the same number of the first members of the group,
+/// so that solutions differing only in the choice between interchangeable engineers are stored only once.
+EngineerSet normalizeInterchangeable( EngineerSet engineerSet, const vector< InterchangeableEngineers > & groups )
+{
+	for (const InterchangeableEngineers & group : groups)
+	{
+		size_t numOfUsed = (engineerSet & group.members).size();
+		engineerSet = engineerSet - group.members;
+		for (EngineerIdx memberIdx : group.members)
+		{
+			if (numOfUsed == 0)
+				break;
+			engineerSet.insert( memberIdx );
+			numOfUsed -= 1;
+		}
+	}
+	return engineerSet;
 }
 
+/// the algorithms that can find the best engineer combinations
+enum class SearchEngine
+{
+	DepthFirst,  ///< recursive search through the choices of engineers for each modification
+	TreeDP,  ///< dynamic programming over the forest of engineer requirements
+	MeetInTheMiddle,  ///< separate enumeration of two halves of the modifications, joined at the end
+	ClosedSetTable,  ///< scan of a precomputed table of engineer sets, only for requests without pins
+};
+
+class ClosedSetTable;
+class SearchCheckpoint;
+
+/// settings of the search, most of them don't change its result, only the way it gets there
+struct SearchOptions
+{
+	SearchEngine engine = SearchEngine::DepthFirst;
+
+	/// Instead of following a fixed order of the modifications chosen before the search, re-pick the most constrained
+	/// remaining modification on every level of the recursion.
+	bool dynamicOrdering = false;
+
+	/// how many buckets the table of already explored search states can use, each takes about 50 bytes
+	size_t transpositionTableSize = 1 << 16;
+
+	/// how much memory the meet-in-the-middle engine can use for its tables, before it gives up
+	size_t memoryLimit = size_t(256) << 20;
+
+	/// how many threads the depth-first search can use
+	uint numOfThreads = 1;
+
+	/// After this time the depth-first search stops and returns the best solutions found until then, zero means no limit.
+	std::chrono::milliseconds timeBudget { 0 };
+
+	/// If not empty, the depth-first search stores its state into this file regularly, and when it's stopped.
+	string checkpointFileName;
+	std::chrono::seconds checkpointInterval { 60 };
+
+	/// the stored state from which the depth-first search should continue, instead of starting from the beginning
+	const SearchCheckpoint * resumeFrom = nullptr;
+
+	/// Only count the best solutions, and keep just the first maxSolutions of them, see countBestEngineerCombinations().
+	bool countSolutions = false;
+	size_t maxSolutions = SIZE_MAX;
+
+	/// If not zero, the depth-first search finds this many best sets of engineers, not only those of the best size.
+	/** In this k-best mode a set is a solution if each of its engineers is required by an engineer chosen for some
+	  * modification, the presolve keeps all such sets, and the search runs on a single thread.
+	  * Counting the solutions takes precedence over it. */
+	size_t numOfBestSolutions = 0;
+
+	/// the table used by the SearchEngine::ClosedSetTable
+	const ClosedSetTable * closedSetTable = nullptr;
+};
+
+/// information about how the search went, that doesn't affect the result
+struct SearchReport
+{
+	size_t numOfStoredStates = 0;  ///< number of states kept in the tables of the meet-in-the-middle engine
+	size_t memoryUsed = 0;  ///< approximate memory taken by those tables
+	bool memoryLimitExceeded = false;  ///< the engine gave up and the depth-first search was used instead
+	bool timeBudgetExceeded = false;  ///< the search was stopped, so it's not proven that the solutions are the best
+	uint lowerBound = 0;  ///< when the search was stopped, no solution can have fewer engineers than this
+	uint64_t numOfExploredStates = 0;  ///< states entered by the resumable search, including the previous runs
+	bool checkpointMismatch = false;  ///< the checkpoint to resume from was made for a different search
+	bool checkpointSaveFailed = false;
+};
+
+/// a subtree of the search, that can be explored independently of the others
+struct SearchTask
+{
+	SearchState state;
+	vector< const DesiredModContext * > modOrder;
+	size_t position;
+};
+
+/// marks a state from which no valid solution can be reached
+static constexpr uint unreachable = uint(-1);
+
 /// intermediate results and support data
 struct AlgorithmContext
 {
+	SearchOptions options;
+
+	/// the first of the DesiredModContexts, for converting pointers to indexes
+	const DesiredModContext * firstModCtx;
+
+	/// The order in which the modifications are decided, the ones from the current position on are still undecided.
+	/** In the dynamic ordering the next chosen modification is swapped to the current position, via the undo trail. */
+	vector< const DesiredModContext * > modOrder;
+
 	/// gradually constructed during the recursive combination generation
-	Solution currentSolution;
+	SearchState currentState;
+
+	/// records of changes to the currentState, so that they can be reverted when backtracking
+	UndoTrail trail;
+
+	/// States from which the whole subtree was already explored.
+	/** Which unpinned mods are satisfied follows from the required engineers, so together with the pinned engineers
+	  * and the decided pinned mods this fully describes the rest of the search. Exploring the subtree again could only
+	  * find the same solutions, because the best size can only decrease. */
+	TranspositionTable exploredStates;
+
+	/// false when the decided mods don't fit into the key of the exploredStates, which can happen only in the k-best mode
+	bool useExploredStates = true;
+
+	/// bit of each pinned mod in SearchState::decidedPinnedMods, indexed the same way as the DesiredModContexts
+	/** In the k-best mode every mod has its bit, because the unpinned ones are decided even when already satisfied. */
+	vector< uint64_t > pinnedModBits;
+
+	/// In the k-best mode, the best sets of engineers found so far, at most SearchOptions::numOfBestSolutions of them.
+	/** bestSize is then the size of the worst of them, once there are enough of them. */
+	set< EngineerSet, SmallerEngineerSet > kBestSolutions;
+
+	/// In the parallel search, the best size found by any of the threads, so that all of them can prune with it.
+	std::atomic< uint > * sharedBestSize = nullptr;
+
+	/// If not null, the states at the splitDepth are collected here as tasks for the threads, instead of being explored.
+	vector< SearchTask > * tasks = nullptr;
+	uint splitDepth = 0;
+
+	/// current depth of the recursion
+	uint depth = 0;
 
-	/// list of solutions of the best size found so far
-	set< Solution > bestSolutions;
+	/// when the search has to stop, if SearchOptions::timeBudget is set
+	std::chrono::steady_clock::time_point deadline;
+
+	/// reading the clock on every call would slow the search down, so it's read only once per this many calls
+	uint callsUntilClockCheck = 0;
+
+	/// the search was stopped at the deadline, so there might be better solutions than the found ones
+	bool timedOut = false;
+
+	/// when the search was stopped, the lowest bound of the subtrees it didn't get to, see boundUnexploredState()
+	uint openLowerBound = unreachable;
+
+	/// number of engineers required by the best solutions found so far, or by the initial estimate
+	/** For simplicity we just compare the number of engineers in the set,
+	  * but we could account for the difficulty of unlocking each engineer. */
+	uint bestSize;
+
+	/// list of solutions of the best size found so far, with the interchangeable engineers normalized
+	SolutionPool bestSolutions;
+
+	/// groups of engineers of which the search uses only some, see InterchangeableEngineers
+	vector< InterchangeableEngineers > interchangeableGroups;
 
 	/// whether at least one valid solution was found
 	/** We need this for verification that the user didn't enter requirements that are impossible to satisfy. */
 	bool foundSolution;
 };
 
-/// This compares 2 sets of engineers required to be unlocked and decides which one is faster to unlock.
-int compare( const Solution & solution1, const Solution & solution2 )
-{
-	// For simplicity we just compare the number of engineers in the set,
-	// but we could account for the difficulty of unlocking each engineer.
-	return ushort( solution2.requiredEngineers.size() ) - ushort( solution1.requiredEngineers.size() );
-}
-bool isBetter( const Solution & solution1, const Solution & solution2 )
+/// Computes a lower bound of how many engineers will have to be added to the current set of required engineers,
+/// so that all the remaining modifications can be satisfied.
+/** Each remaining modification alone needs at least the cheapest of its candidates' closures, and modifications whose
+  * candidates' closures don't share any engineer that isn't required yet need their costs added together.
+  * Every undecided pinned modification also needs its own engineer that isn't pinning anything yet, and only
+  * the required engineers that aren't pinning anything come for free.
+  * So the bound is the best of the most expensive single modification, the sum over such an independent group,
+  * and the pinned modifications without a free engineer, it never overestimates, and the search can stop whenever
+  * the bound shows the result couldn't be the best.
+  * The computation stops as soon as the bound exceeds \p limit, because then the exact value isn't interesting.
+  * Returns \c unreachable if some remaining pinned modification has no engineer left to pin it. */
+uint estimateAdditionalEngineers( const AlgorithmContext & ctx, size_t position, uint limit )
 {
-	return compare( solution1, solution2 ) > 0;
-}
-bool isBetterOrEqual( const Solution & solution1, const Solution & solution2 )
-{
-	return compare( solution1, solution2 ) >= 0;
-}
+	const SearchState & state = ctx.currentState;
 
-/// Adds all engineers that are required to be unlocked to unlock this engineer, including this engineer himself.
-void addEngineerWithAllRequirements( EngineerIdx engineerIdx, EngineerSet & requiredEngineers )
-{
-	EngineerIdx currentEngineerIdx = engineerIdx;
-	while (currentEngineerIdx != EngineerIdx::None)
+	uint maxSingle = 0;  // the most expensive modification
+	uint independentSum = 0;  // sum of costs of modifications whose candidates don't share unrequired engineers
+	EngineerSet independentEngineers;  // all unrequired engineers that any of those modifications could add
+	uint numOfPinnedMods = 0;  // undecided pinned modifications
+
+	for (; position < ctx.modOrder.size(); ++position)
 	{
-		requiredEngineers.insert( currentEngineerIdx );
-		currentEngineerIdx = engineers[ currentEngineerIdx ].requiredEngineer;
-	}
-}
+		const DesiredModContext * currentModCtx = ctx.modOrder[ position ];
+
+		EngineerSet candidates = currentModCtx->engineers;
+		if (currentModCtx->mod.pinRequired)
+		{
+			candidates = candidates - state.pinnedEngineers;
+			numOfPinnedMods += 1;
+		}
+
+		if (candidates.empty())
+			return unreachable;
+
+		// nothing needs to be added, if some engineer offering the mod is already required,
+		// and if the bound can't exceed the limit anyway, the cost doesn't need to be computed
+		if (!(candidates & state.requiredEngineers).empty() || limit == unreachable)
+			continue;
+
+		uint cheapest = unreachable;
+		EngineerSet addableEngineers;
+		for (EngineerIdx engineerIdx : candidates)
+		{
+			EngineerSet missingEngineers = requirementsOf( engineerIdx ) - state.requiredEngineers;
+			cheapest = std::min( cheapest, uint( missingEngineers.size() ) );
+			addableEngineers |= missingEngineers;
+		}
+
+		maxSingle = std::max( maxSingle, cheapest );
+		if ((addableEngineers & independentEngineers).empty())
+		{
+			independentSum += cheapest;
+			independentEngineers |= addableEngineers;
+		}
+
+		if (std::max( maxSingle, independentSum ) > limit)
+			break;
+	}
+
+	const uint numOfFreeEngineers = uint( (state.requiredEngineers - state.pinnedEngineers).size() );
+	const uint pinnedWithoutEngineer = numOfPinnedMods > numOfFreeEngineers ? numOfPinnedMods - numOfFreeEngineers : 0;
+
+	return std::max({ maxSingle, independentSum, pinnedWithoutEngineer });
+}
+
+/// Removes the candidates that never need to be tried for a modification, because another candidate is at least as good.
+/** Candidate C is dominated by candidate A, if choosing A adds a strict subset of the engineers that choosing C adds
+  * to the \p requiredEngineers. Every solution using C for this modification can then be turned into a solution using A,
+  * whose set of engineers is the same or smaller, so no solution of the best size is lost. For a pinned modification
+  * that's true only if A can't be needed for pinning another modification, so only the \p freeForPinning candidates
+  * can dominate the others there. */
+EngineerSet removeDominatedCandidates(
+	EngineerSet candidates, EngineerSet requiredEngineers, bool pinRequired, EngineerSet freeForPinning
+)
+{
+	EngineerSet dominatingCandidates = pinRequired ? candidates & freeForPinning : candidates;
+
+	EngineerSet undominatedCandidates = candidates;
+	for (EngineerIdx dominatingIdx : dominatingCandidates)
+	{
+		EngineerSet addedByDominating = requirementsOf( dominatingIdx ) - requiredEngineers;
+		for (EngineerIdx candidateIdx : candidates)
+		{
+			EngineerSet addedByCandidate = requirementsOf( candidateIdx ) - requiredEngineers;
+			if (addedByDominating != addedByCandidate && addedByDominating.isSubsetOf( addedByCandidate ))
+				undominatedCandidates.erase( candidateIdx );
+		}
+	}
+	return undominatedCandidates;
+}
+
+/// Tries to find another engineer for the pinned mod \p modIdx, that isn't pinned yet or visited by the current search,
+/// moving the other pinned mods to different engineers if needed (augmenting path of the bipartite matching).
+/** The changes of the matching are recorded to the undo trail. */
+bool findAugmentingPath( AlgorithmContext & ctx, size_t modIdx, EngineerSet & visitedEngineers )
+{
+	SearchState & state = ctx.currentState;
+
+	EngineerSet candidates = ctx.firstModCtx[ modIdx ].engineers - state.pinnedEngineers - visitedEngineers;
+	for (EngineerIdx engineerIdx : candidates)
+	{
+		visitedEngineers.insert( engineerIdx );
+		size_t ownerIdx = state.matchedMod[ engineerIdx ];
+		if (ownerIdx == 0 || findAugmentingPath( ctx, ownerIdx - 1, visitedEngineers ))
+		{
+			ctx.trail.assign( state.pinMatching[ modIdx ], engineerIdx );
+			ctx.trail.assign( state.matchedMod[ engineerIdx ], modIdx + 1 );
+			return true;
+		}
+	}
+	return false;
+}
+
+/// Pins the engineer for the mod \p modIdx and repairs the matching of the other pinned mods.
+/** Returns false if the undecided pinned mods can't get a different engineer each anymore. */
+bool pinEngineer( AlgorithmContext & ctx, size_t modIdx, EngineerIdx engineerIdx )
+{
+	SearchState & state = ctx.currentState;
+
+	ctx.trail.assign( state.pinnedEngineers, state.pinnedEngineers | EngineerSet( EngineerMask(1) << engineerIdx ) );
+
+	const EngineerIdx previousEngineerIdx = state.pinMatching[ modIdx ];
+	const size_t displacedIdx = state.matchedMod[ engineerIdx ];
+	if (displacedIdx == modIdx + 1)
+		return true;  // this engineer is already matched to the mod
+
+	ctx.trail.assign( state.matchedMod[ previousEngineerIdx ], size_t(0) );
+	ctx.trail.assign( state.pinMatching[ modIdx ], engineerIdx );
+	ctx.trail.assign( state.matchedMod[ engineerIdx ], modIdx + 1 );
+	if (displacedIdx == 0)
+		return true;
+
+	// the mod that was matched to this engineer needs another one
+	EngineerSet visitedEngineers;
+	return findAugmentingPath( ctx, displacedIdx - 1, visitedEngineers );
+}
+
+/// Chooses the modification the next level of the recursion will branch on.
+/** Unpinned modifications already offered by some of the required engineers are skipped, because choosing any other
+  * engineer for them could only make the solution larger, which only the k-best mode needs.
+  * From the rest it takes either the first one in the order, or with the dynamic ordering the one with the fewest
+  * engineers to choose from, preferring the pinned ones.
+  * Returns the position of the chosen modification in ctx.modOrder, or its size if all modifications are satisfied. */
+size_t pickNextMod( const AlgorithmContext & ctx, size_t position )
+{
+	const SearchState & state = ctx.currentState;
+
+	size_t bestPosition = ctx.modOrder.size();
+	uint fewestCandidates = unreachable;
+	bool bestIsPinned = false;
+
+	for (; position < ctx.modOrder.size(); ++position)
+	{
+		const DesiredModContext * modCtx = ctx.modOrder[ position ];
+
+		if (!modCtx->mod.pinRequired && !(modCtx->engineers & state.requiredEngineers).empty()
+		 && ctx.options.numOfBestSolutions == 0)
+			continue;
+
+		if (!ctx.options.dynamicOrdering)
+			return position;
+
+		EngineerSet candidates = modCtx->engineers;
+		if (modCtx->mod.pinRequired)
+			candidates = candidates - state.pinnedEngineers;
+		uint numOfCandidates = uint( candidates.size() );
+
+		if (numOfCandidates < fewestCandidates || (numOfCandidates == fewestCandidates && modCtx->mod.pinRequired && !bestIsPinned))
+		{
+			bestPosition = position;
+			fewestCandidates = numOfCandidates;
+			bestIsPinned = modCtx->mod.pinRequired;
+		}
+	}
+
+	return bestPosition;
+}
+
+/// Checks whether the search is out of its time budget, once it is, all the recursive calls return immediately.
+bool deadlinePassed( AlgorithmContext & ctx )
+{
+	if (ctx.timedOut)
+		return true;
+	if (ctx.options.timeBudget.count() == 0 || ctx.callsUntilClockCheck-- > 0)
+		return false;
+
+	ctx.callsUntilClockCheck = 1023;
+	ctx.timedOut = std::chrono::steady_clock::now() >= ctx.deadline;
+	return ctx.timedOut;
+}
+
+/// Adds a complete solution to the best ones, if it's at least as good as them.
+void addSolution( AlgorithmContext & ctx, EngineerSet solutionEngineers )
+{
+	uint currentSize = uint( solutionEngineers.size() );
+	if (currentSize > ctx.bestSize)
+		return;
+
+	// in the k-best mode the worst solution is replaced, and the bound becomes the size of the new worst one
+	const size_t numOfBestSolutions = ctx.options.numOfBestSolutions;
+	if (numOfBestSolutions != 0)
+	{
+		ctx.kBestSolutions.insert( solutionEngineers );
+		if (ctx.kBestSolutions.size() > numOfBestSolutions)
+			ctx.kBestSolutions.erase( std::prev( ctx.kBestSolutions.end() ) );
+		if (ctx.kBestSolutions.size() == numOfBestSolutions)
+			ctx.bestSize = uint( ctx.kBestSolutions.rbegin()->size() );
+		ctx.foundSolution = true;
+		return;
+	}
+	if (currentSize < ctx.bestSize)  // this solution is better than all the added ones, replace them
+	{
+		ctx.bestSolutions.clear();
+		ctx.bestSize = currentSize;
+
+		// let the other threads know
+		if (ctx.sharedBestSize)
+		{
+			uint sharedSize = ctx.sharedBestSize->load( std::memory_order_relaxed );
+			while (currentSize < sharedSize && !ctx.sharedBestSize->compare_exchange_weak( sharedSize, currentSize ))
+				;
+		}
+	}
+
+	solutionEngineers = normalizeInterchangeable( solutionEngineers, ctx.interchangeableGroups );
+	ctx.bestSolutions.insert( solutionEngineers );
+	ctx.foundSolution = true;
+}
+
+/// Evaluates all the complete solutions made by choosing one of the \p candidates for the last undecided modification.
+/** The sizes of all the solutions are computed at once, and only those at least as good as the best ones so far
+  * are normalized and given to the pool. */
+void evaluateLastLevel( AlgorithmContext & ctx, EngineerSet candidates )
+{
+	SearchState & state = ctx.currentState;
+
+	EngineerMask closures [ numOfEngineers ];
+	uint32_t sizes [ numOfEngineers ];
+	size_t numOfCandidates = 0;
+	for (EngineerIdx engineerIdx : candidates)
+		closures[ numOfCandidates++ ] = requirementClosures[ engineerIdx ];
+	simdKernels().unionSizes( closures, numOfCandidates, state.requiredEngineers.mask(), sizes );
+
+	size_t candidateIdx = 0;
+	for (EngineerIdx engineerIdx : candidates)
+	{
+		if (sizes[ candidateIdx++ ] > ctx.bestSize)
+			continue;
+
+		addSolution( ctx, state.requiredEngineers | requirementsOf( engineerIdx ) );
+	}
+}
+
+/// one level of the search: the chosen modification and its candidates, that are tried one by one
+struct SearchNode
+{
+	const DesiredModContext * modCtx;
+	size_t nextPosition;  ///< position in ctx.modOrder, from which the modifications are undecided after this one
+	EngineerSet candidates;
+	UndoTrail::Mark levelMark;  ///< state before the modification was chosen
+};
+
+/// Lowers ctx.openLowerBound to the bound of the current state, whose subtree the search won't explore.
+void boundUnexploredState( AlgorithmContext & ctx, size_t position )
+{
+	const uint additionalEngineers = estimateAdditionalEngineers( ctx, position, unreachable - 1 );
+	if (additionalEngineers != unreachable)
+	{
+		const uint bound = uint( ctx.currentState.requiredEngineers.size() ) + additionalEngineers;
+		ctx.openLowerBound = std::min( ctx.openLowerBound, bound );
+	}
+}
+
+/// Everything the search does when it gets to a new state, before the candidates of the next modification are tried.
+/** Returns false if the candidates don't need to be tried one by one, because the state is a complete solution,
+  * it was already explored, it was collected as a task, or all its solutions were evaluated at once. */
+bool enterSearchState( AlgorithmContext & ctx, size_t position, SearchNode & node )
+{
+	SearchState & state = ctx.currentState;
+
+	// another thread might have found a better solution, the worse ones found here are not needed anymore
+	if (ctx.sharedBestSize)
+	{
+		uint sharedSize = ctx.sharedBestSize->load( std::memory_order_relaxed );
+		if (sharedSize < ctx.bestSize)
+		{
+			ctx.bestSolutions.clear();
+			ctx.bestSize = sharedSize;
+		}
+	}
+
+	if (deadlinePassed( ctx ))
+	{
+		boundUnexploredState( ctx, position );
+		return false;
+	}
+
+	size_t chosenPosition = pickNextMod( ctx, position );
+	if (chosenPosition == ctx.modOrder.size())
+	{
+		// whole combination has been generated, evaluate it
+		addSolution( ctx, state.requiredEngineers );
+		return false;
+	}
+
+	// the same engineers might have been reached in a different order before
+	if (ctx.useExploredStates)
+	{
+		const TranspositionTable::Key stateKey = { state.requiredEngineers, state.pinnedEngineers, state.decidedPinnedMods };
+		if (ctx.exploredStates.contains( stateKey ))
+			return false;
+		ctx.exploredStates.insert( stateKey, uint( position ) );
+	}
+
+	// in the parallel search, the top levels of the recursion only divide the work
+	if (ctx.tasks && ctx.depth == ctx.splitDepth)
+	{
+		ctx.tasks->push_back({ state, ctx.modOrder, position });
+		return false;
+	}
+
+	// the swap will be reverted when all engineers of the chosen modification are done
+	node.levelMark = ctx.trail.mark();
+	if (ctx.options.dynamicOrdering)
+	{
+		const DesiredModContext * chosenModCtx = ctx.modOrder[ chosenPosition ];
+		ctx.trail.assign( ctx.modOrder[ chosenPosition ], ctx.modOrder[ position ] );
+		ctx.trail.assign( ctx.modOrder[ position ], chosenModCtx );
+		chosenPosition = position;
+	}
+	node.modCtx = ctx.modOrder[ chosenPosition ];
+	node.nextPosition = chosenPosition + 1;
+
+	// Only one modification per engineer can be pinned, so if the current mod is required to be pinned,
+	// skip the engineers that are already used for pinning the previous modifications.
+	EngineerSet candidates = node.modCtx->engineers;
+	EngineerSet freeForPinning;
+	if (node.modCtx->mod.pinRequired)
+	{
+		candidates = candidates - state.pinnedEngineers;
+
+		// the engineers that can't be needed for pinning any of the undecided modifications
+		EngineerSet competingEngineers;
+		for (size_t pos = node.nextPosition; pos < ctx.modOrder.size(); ++pos)
+			if (ctx.modOrder[ pos ]->mod.pinRequired)
+				competingEngineers |= ctx.modOrder[ pos ]->engineers;
+		freeForPinning = candidates - competingEngineers;
+	}
+
+	// With the engineers required so far, some candidates might now be worse than others.
+	// In the k-best mode the worse ones are needed too, but all the candidates already required give the same set.
+	if (ctx.options.numOfBestSolutions == 0)
+	{
+		node.candidates = removeDominatedCandidates( candidates, state.requiredEngineers, node.modCtx->mod.pinRequired, freeForPinning );
+	}
+	else if (!node.modCtx->mod.pinRequired && !(candidates & state.requiredEngineers).empty())
+	{
+		node.candidates = candidates - state.requiredEngineers;
+		node.candidates.insert( *(candidates & state.requiredEngineers).begin() );
+	}
+	else
+	{
+		node.candidates = candidates;
+	}
+
+	// When nothing else is left to decide, each candidate leads directly to a complete solution.
+	// No other pinned modification is undecided, so pinning the candidate can't break the matching either.
+	if (pickNextMod( ctx, node.nextPosition ) == ctx.modOrder.size())
+	{
+		evaluateLastLevel( ctx, node.candidates );
+		ctx.trail.undoTo( node.levelMark );
+		return false;
+	}
+
+	return true;
+}
+
+/// Adds the engineer as the choice for the modification of the \p node,
+/// and returns whether the rest of the combination can still lead to one of the best solutions.
+/** The changes are recorded in the undo trail, even when it returns false. */
+bool chooseEngineer( AlgorithmContext & ctx, const SearchNode & node, EngineerIdx engineerIdx )
+{
+	SearchState & state = ctx.currentState;
+
+	// add all the engineers that are required to be unlocked in order to unlock this one
+	ctx.trail.assign( state.requiredEngineers, state.requiredEngineers | requirementsOf( engineerIdx ) );
+	// pinning more modifications from this engineer will not be possible,
+	// and all the remaining pinned modifications must still be able to get a different engineer
+	const size_t modIdx = size_t( node.modCtx - ctx.firstModCtx );
+	if (ctx.pinnedModBits[ modIdx ] != 0)
+		ctx.trail.assign( state.decidedPinnedMods, state.decidedPinnedMods | ctx.pinnedModBits[ modIdx ] );
+	bool pinsMatchable = true;
+	if (node.modCtx->mod.pinRequired)
+		pinsMatchable = pinEngineer( ctx, modIdx, engineerIdx );
+
+	// optimization: If it can't be at least as good as the best solution deeper in the recursion, abort here.
+	uint currentSize = uint( state.requiredEngineers.size() );
+	uint maxAdditionalEngineers = unreachable;
+	if (ctx.bestSize != unreachable)
+		maxAdditionalEngineers = ctx.bestSize >= currentSize ? ctx.bestSize - currentSize : 0;
+	uint additionalEngineers = pinsMatchable ? estimateAdditionalEngineers( ctx, node.nextPosition, maxAdditionalEngineers ) : unreachable;
+	return currentSize <= ctx.bestSize && additionalEngineers != unreachable && additionalEngineers <= maxAdditionalEngineers;
+}
+
+/// Lowers ctx.openLowerBound to the bounds of the subtrees of the \p untried candidates of the \p node.
+/** Those that chooseEngineer() prunes can't lead to anything better than the solutions already found. */
+void boundUntriedCandidates( AlgorithmContext & ctx, const SearchNode & node, EngineerSet untried )
+{
+	for (EngineerIdx engineerIdx : untried)
+	{
+		const UndoTrail::Mark mark = ctx.trail.mark();
+		if (chooseEngineer( ctx, node, engineerIdx ))
+			boundUnexploredState( ctx, node.nextPosition );
+		ctx.trail.undoTo( mark );
+	}
+}
+
+/// The core of the algorithm, recursive function.
+/** \param ctx       intermediate results for the algorithm
+  * \param position  position in ctx.modOrder, from which the modifications are still undecided
+  * Executes one level of dynamic cascade of nested for-loops that generates all combinations of engineers from
+  * the given engineer sets, and calculates how many other engineers need to be unlocked to get access
+  * to these engineers in these sets. */
+void tryAllEngineerCombinations( AlgorithmContext & ctx, size_t position )
+{
+	SearchNode node;
+	if (!enterSearchState( ctx, position, node ))
+		return;
+
+	// If all engineers offering this modification are already used for pinning the previous modifications,
+	// this loop simply performs no iteration and this combination is not finished and evaluated.
+	EngineerSet untried = node.candidates;
+	for (EngineerIdx engineerIdx : node.candidates)
+	{
+		untried.erase( engineerIdx );
+
+		// everything changed from now on will be reverted back to this mark when this engineer is done
+		const UndoTrail::Mark mark = ctx.trail.mark();
+
+		if (chooseEngineer( ctx, node, engineerIdx ))
+		{
+			// continue with generating the rest of the combination
+			ctx.depth += 1;
+			tryAllEngineerCombinations( ctx, node.nextPosition );
+			ctx.depth -= 1;
+		}
+
+		// restore the previous state of the search
+		ctx.trail.undoTo( mark );
+
+		if (ctx.timedOut)
+		{
+			boundUntriedCandidates( ctx, node, untried );
+			break;
+		}
+	}
+
+	ctx.trail.undoTo( node.levelMark );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//  resumable search
+//
+//  The same search as tryAllEngineerCombinations(), but with the recursion replaced by an explicit stack of frames,
+//  so that it can be interrupted at any point, stored into a file, and continued later, even by another process.
+//  Only the choices on the stack are stored, the rest of the state is rebuilt by replaying them from the beginning.
+//  The table of explored states is not stored, so after resuming some states may get explored again,
+//  which only finds the same solutions again.
+
+/// State of an interrupted depth-first search.
+class SearchCheckpoint
+{
+	static constexpr char fileMagic [4] = { 'E', 'D', 'C', 'P' };
+	static constexpr uint32_t fileVersion = 2;
+
+	/// limits of the loaded numbers, so that a damaged file can't make us allocate everything
+	static constexpr uint32_t maxNumOfMods = 1 << 16;
+	static constexpr uint64_t maxNumOfSolutions = uint64_t(1) << numOfEngineers;
+
+ public:
+
+	/// one level of the explicit stack
+	struct Frame
+	{
+		uint32_t position;  ///< position in ctx.modOrder, from which the modifications were undecided when it was entered
+		EngineerSet untried;  ///< candidates that are still to be tried
+		EngineerIdx current;  ///< the candidate being tried, the next frame is in its subtree
+	};
+
+	uint64_t inputHash = 0;  ///< identifies the search, see searchInputHash()
+	uint64_t numOfExploredStates = 0;
+	bool finished = false;  ///< the whole tree was explored, the solutions are final
+	uint32_t bestSize = 0;
+	uint32_t numOfMods = 0;
+	vector< EngineerSet > solutions;
+	/// From the root, the top frame's current candidate is chosen, but its subtree isn't entered yet.
+	/** If there are no frames in an unfinished checkpoint, not even the root was entered. */
+	vector< Frame > frames;
+
+	/// Stores the checkpoint in the native byte order, returns false if the file can't be written.
+	/** The file is written under a temporary name first and then renamed, so that the previous checkpoint is kept
+	  * if the process gets killed while writing. */
+	bool save( const string & fileName ) const
+	{
+		const string tempFileName = fileName + ".tmp";
+		{
+			ofstream file( tempFileName, std::ios::binary );
+			if (!file.is_open())
+				return false;
+
+			auto write = [ &file ]( const auto & value )
+			{
+				file.write( reinterpret_cast< const char * >( &value ), sizeof(value) );
+			};
+			write( fileMagic );
+			write( fileVersion );
+			write( inputHash );
+			write( numOfExploredStates );
+			write( uint8_t( finished ) );
+			write( bestSize );
+			write( numOfMods );
+			write( uint64_t( solutions.size() ) );
+			for (EngineerSet solution : solutions)
+				write( solution.mask() );
+			write( uint32_t( frames.size() ) );
+			for (const Frame & frame : frames)
+			{
+				write( frame.position );
+				write( frame.untried.mask() );
+				write( uint8_t( frame.current ) );
+			}
+
+			if (!file)
+				return false;
+		}
+		return std::rename( tempFileName.c_str(), fileName.c_str() ) == 0;
+	}
+
+	enum class LoadResult
+	{
+		Success,
+		CantOpen,
+		InvalidFormat,
+	};
+
+	LoadResult load( const string & fileName )
+	{
+		ifstream file( fileName, std::ios::binary );
+		if (!file.is_open())
+			return LoadResult::CantOpen;
+
+		auto read = [ &file ]( auto & value )
+		{
+			file.read( reinterpret_cast< char * >( &value ), sizeof(value) );
+		};
+		auto readEngineer = [ &read ]( EngineerIdx & engineerIdx )
+		{
+			uint8_t byte = 0;
+			read( byte );
+			engineerIdx = byte < EngineerIdx::_EndOfEnum ? EngineerIdx( byte ) : EngineerIdx::_EndOfEnum;
+			return engineerIdx != EngineerIdx::_EndOfEnum;
+		};
+
+		char magic [4];
+		uint32_t version = 0;
+		uint8_t finishedByte = 0;
+		uint64_t numOfSolutions = 0;
+		read( magic );
+		read( version );
+		read( inputHash );
+		read( numOfExploredStates );
+		read( finishedByte );
+		read( bestSize );
+		read( numOfMods );
+		read( numOfSolutions );
+		if (!file || memcmp( magic, fileMagic, sizeof(magic) ) != 0 || version != fileVersion
+		 || numOfMods > maxNumOfMods || numOfSolutions > maxNumOfSolutions)
+			return LoadResult::InvalidFormat;
+		finished = finishedByte != 0;
+
+		solutions.clear();
+		for (size_t idx = 0; idx < numOfSolutions; ++idx)
+		{
+			EngineerMask mask = 0;
+			read( mask );
+			solutions.push_back( EngineerSet( mask ) );
+		}
+
+		uint32_t numOfFrames = 0;
+		read( numOfFrames );
+		if (!file || numOfFrames > numOfMods)
+			return LoadResult::InvalidFormat;
+		frames.resize( numOfFrames );
+		for (Frame & frame : frames)
+		{
+			EngineerMask untried = 0;
+			read( frame.position );
+			read( untried );
+			frame.untried = EngineerSet( untried );
+			if (!readEngineer( frame.current ) || frame.position >= numOfMods)
+				return LoadResult::InvalidFormat;
+		}
+
+		return file ? LoadResult::Success : LoadResult::InvalidFormat;
+	}
+};
+
+/// Identifies everything the search tree depends on, so that a checkpoint is not resumed by a different search.
+/** FNV-1a hash, must be computed before the search starts. */
+uint64_t searchInputHash( const AlgorithmContext & ctx )
+{
+	uint64_t hash = 0xCBF29CE484222325u;
+	auto addWord = [ &hash ]( uint64_t word )
+	{
+		for (size_t byteIdx = 0; byteIdx < sizeof(word); ++byteIdx)
+			hash = (hash ^ uint8_t( word >> (8 * byteIdx) )) * 0x100000001B3u;
+	};
+
+	addWord( ctx.options.dynamicOrdering );
+	addWord( ctx.currentState.requiredEngineers.mask() );
+	addWord( ctx.currentState.pinnedEngineers.mask() );
+	for (const DesiredModContext * modCtx : ctx.modOrder)
+	{
+		addWord( uint64_t( modCtx - ctx.firstModCtx ) );
+		addWord( uint64_t( modCtx->mod.module ) );
+		addWord( uint64_t( modCtx->mod.grade ) );
+		addWord( modCtx->mod.pinRequired );
+		addWord( modCtx->engineers.mask() );
+	}
+	for (const InterchangeableEngineers & group : ctx.interchangeableGroups)
+	{
+		addWord( group.members.mask() );
+		addWord( group.searched.mask() );
+	}
+	for (EngineerIdx engineerIdx = firstEngineerIdx; engineerIdx <= lastEngineerIdx; engineerIdx = inc( engineerIdx ))
+		addWord( requirementsOf( engineerIdx ).mask() );
+	return hash;
+}
+
+/// a level of the explicit stack, while the search is running
+struct SearchFrame
+{
+	size_t position;
+	SearchNode node;
+	EngineerSet untried;
+	EngineerIdx current = EngineerIdx::None;  ///< None if no candidate is chosen at the moment
+	UndoTrail::Mark mark;  ///< state before the current candidate was chosen
+};
+
+/// Enters the state reached by the choices on the \p stack, and adds a frame for it, if it has candidates to try.
+void pushSearchFrame( AlgorithmContext & ctx, vector< SearchFrame > & stack, size_t position, uint64_t & numOfExploredStates )
+{
+	SearchFrame frame;
+	frame.position = position;
+	ctx.depth = uint( stack.size() );
+	if (enterSearchState( ctx, position, frame.node ))
+	{
+		frame.untried = frame.node.candidates;
+		stack.push_back( frame );
+	}
+	numOfExploredStates += 1;
+}
+
+void storeCheckpoint( const AlgorithmContext & ctx, const vector< SearchFrame > & stack, uint64_t inputHash,
+                      uint64_t numOfExploredStates, SearchReport & report )
+{
+	SearchCheckpoint checkpoint;
+	checkpoint.inputHash = inputHash;
+	checkpoint.numOfExploredStates = numOfExploredStates;
+	checkpoint.finished = stack.empty() && !ctx.timedOut;
+	checkpoint.bestSize = ctx.bestSize;
+	checkpoint.numOfMods = uint32_t( ctx.modOrder.size() );
+	for (size_t idx = 0; idx < ctx.bestSolutions.size(); ++idx)
+		checkpoint.solutions.push_back( ctx.bestSolutions.engineers( idx ) );
+	for (const SearchFrame & frame : stack)
+		checkpoint.frames.push_back({ uint32_t( frame.position ), frame.untried, frame.current });
+
+	if (!checkpoint.save( ctx.options.checkpointFileName ))
+		report.checkpointSaveFailed = true;
+}
+
+/// Rebuilds the search state from the choices stored in the \p checkpoint.
+/** If the stored best size prunes some of the choices now, the stack is cut there, because the rest of that subtree
+  * couldn't lead to the best solutions anyway. Returns whether all the stored choices were replayed. */
+bool replayCheckpoint( AlgorithmContext & ctx, const SearchCheckpoint & checkpoint, vector< SearchFrame > & stack )
+{
+	ctx.bestSize = checkpoint.bestSize;
+	for (EngineerSet solution : checkpoint.solutions)
+		ctx.bestSolutions.insert( solution );
+	ctx.foundSolution = !ctx.bestSolutions.empty();
+
+	// the replay must not be interrupted by the deadline, otherwise a part of the tree would be lost
+	ctx.callsUntilClockCheck = uint( checkpoint.frames.size() ) + 1;
+
+	bool replayedAll = true;
+	for (const SearchCheckpoint::Frame & storedFrame : checkpoint.frames)
+	{
+		SearchFrame frame;
+		frame.position = storedFrame.position;
+		ctx.depth = uint( stack.size() );
+		if (!enterSearchState( ctx, frame.position, frame.node ))
+		{
+			replayedAll = false;  // the choice of the previous frame is then done
+			break;
+		}
+		frame.untried = storedFrame.untried & frame.node.candidates;
+		frame.mark = ctx.trail.mark();
+		stack.push_back( frame );
+
+		if (!frame.node.candidates.contains( storedFrame.current ) || !chooseEngineer( ctx, frame.node, storedFrame.current ))
+		{
+			ctx.trail.undoTo( frame.mark );
+			replayedAll = false;  // continue with the untried candidates of this frame
+			break;
+		}
+		stack.back().current = storedFrame.current;
+	}
+
+	ctx.callsUntilClockCheck = 0;
+	return replayedAll;
+}
+
+/// Explores the search tree like tryAllEngineerCombinations( ctx, 0 ), regularly storing checkpoints.
+void searchResumably( AlgorithmContext & ctx, SearchReport & report )
+{
+	using Clock = std::chrono::steady_clock;
+
+	const uint64_t inputHash = searchInputHash( ctx );
+	const SearchCheckpoint * checkpoint = ctx.options.resumeFrom;
+	if (checkpoint && (checkpoint->inputHash != inputHash || checkpoint->numOfMods != ctx.modOrder.size()))
+	{
+		report.checkpointMismatch = true;
+		return;
+	}
+
+	vector< SearchFrame > stack;
+	stack.reserve( ctx.modOrder.size() );
+	uint64_t numOfExploredStates = 0;
+	if (checkpoint)
+	{
+		numOfExploredStates = checkpoint->numOfExploredStates;
+		if (checkpoint->finished)
+		{
+			ctx.bestSize = checkpoint->bestSize;
+			for (EngineerSet solution : checkpoint->solutions)
+				ctx.bestSolutions.insert( solution );
+			ctx.foundSolution = !ctx.bestSolutions.empty();
+			report.numOfExploredStates = numOfExploredStates;
+			return;
+		}
+		// the subtree of the chosen candidate on the top of the stack is the next one to be explored
+		if (replayCheckpoint( ctx, *checkpoint, stack ))
+			pushSearchFrame( ctx, stack, stack.empty() ? 0 : stack.back().node.nextPosition, numOfExploredStates );
+	}
+	else
+	{
+		pushSearchFrame( ctx, stack, 0, numOfExploredStates );
+	}
+
+	Clock::time_point nextCheckpoint = Clock::now() + ctx.options.checkpointInterval;
+	uint stepsUntilClockCheck = 1024;
+	while (!stack.empty() && !ctx.timedOut)
+	{
+		SearchFrame & frame = stack.back();
+
+		// the subtree of the current candidate is done, restore the state before it
+		if (frame.current != EngineerIdx::None)
+		{
+			ctx.trail.undoTo( frame.mark );
+			frame.current = EngineerIdx::None;
+		}
+
+		if (frame.untried.empty())
+		{
+			ctx.trail.undoTo( frame.node.levelMark );
+			stack.pop_back();
+			continue;
+		}
+
+		const EngineerIdx engineerIdx = *frame.untried.begin();
+		frame.untried.erase( engineerIdx );
+		frame.mark = ctx.trail.mark();
+		if (!chooseEngineer( ctx, frame.node, engineerIdx ))
+		{
+			ctx.trail.undoTo( frame.mark );
+			continue;
+		}
+		frame.current = engineerIdx;
+
+		// between choosing the candidate and entering its subtree is the only point, where the state can be stored
+		if (--stepsUntilClockCheck == 0)
+		{
+			stepsUntilClockCheck = 1024;
+			if (Clock::now() >= nextCheckpoint)
+			{
+				storeCheckpoint( ctx, stack, inputHash, numOfExploredStates, report );
+				nextCheckpoint = Clock::now() + ctx.options.checkpointInterval;
+			}
+		}
+
+		pushSearchFrame( ctx, stack, frame.node.nextPosition, numOfExploredStates );
+	}
+
+	// when it was stopped by the deadline, the state is stored with the subtree of the top frame not entered yet
+	storeCheckpoint( ctx, stack, inputHash, numOfExploredStates, report );
+	report.numOfExploredStates = numOfExploredStates;
+
+	// the subtree of the top frame's current candidate was bounded when it wasn't entered, the untried ones are left
+	for (size_t frameIdx = stack.size(); frameIdx-- > 0 && ctx.timedOut;)
+	{
+		SearchFrame & frame = stack[ frameIdx ];
+		if (frame.current != EngineerIdx::None)
+			ctx.trail.undoTo( frame.mark );
+		boundUntriedCandidates( ctx, frame.node, frame.untried );
+		ctx.trail.undoTo( frame.node.levelMark );
+	}
+}
+
+
+/// Task queues of the threads of the parallel search.
+/** Each thread takes the tasks from the back of its own queue, and when it runs out of them,
+  * it steals from the front of the queues of the others. */
+class WorkStealingQueues
+{
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque< size_t > taskIdxs;
+	};
+	vector< Queue > queues;
+
+ public:
+
+	explicit WorkStealingQueues( size_t numOfQueues ) : queues( numOfQueues ) {}
+
+	void push( size_t queueIdx, size_t taskIdx )
+	{
+		std::lock_guard< std::mutex > lock( queues[ queueIdx ].mutex );
+		queues[ queueIdx ].taskIdxs.push_back( taskIdx );
+	}
+
+	/// Returns false when there are no tasks left in any of the queues.
+	bool pop( size_t queueIdx, size_t & taskIdx )
+	{
+		{
+			Queue & ownQueue = queues[ queueIdx ];
+			std::lock_guard< std::mutex > lock( ownQueue.mutex );
+			if (!ownQueue.taskIdxs.empty())
+			{
+				taskIdx = ownQueue.taskIdxs.back();
+				ownQueue.taskIdxs.pop_back();
+				return true;
+			}
+		}
+		for (size_t offset = 1; offset < queues.size(); ++offset)
+		{
+			Queue & otherQueue = queues[ (queueIdx + offset) % queues.size() ];
+			std::lock_guard< std::mutex > lock( otherQueue.mutex );
+			if (!otherQueue.taskIdxs.empty())
+			{
+				taskIdx = otherQueue.taskIdxs.front();
+				otherQueue.taskIdxs.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+/// Explores the search tree with multiple threads, and leaves the merged result in the \p ctx.
+/** The top levels of the recursion are cut into tasks, each thread explores them with its own copy of the context,
+  * and the best size is shared between them, so that each thread prunes with the best solution found by any of them.
+  * Every thread finds all the solutions of the best size in its subtrees, so together they have the same solutions
+  * as the serial search, and the result is sorted afterwards anyway. */
+void searchInParallel( AlgorithmContext & ctx, uint numOfThreads )
+{
+	const size_t transpositionTableSize = ctx.options.transpositionTableSize;
+
+	// divide the tree deep enough, so that there are enough tasks for the threads to balance their load
+	vector< SearchTask > tasks;
+	AlgorithmContext splittingCtx;
+	for (uint splitDepth = 0; ; ++splitDepth)
+	{
+		const size_t previousNumOfTasks = tasks.size();
+		tasks.clear();
+		splittingCtx = ctx;
+		splittingCtx.exploredStates = TranspositionTable( transpositionTableSize );
+		splittingCtx.tasks = &tasks;
+		splittingCtx.splitDepth = splitDepth;
+		tryAllEngineerCombinations( splittingCtx, 0 );
+		splittingCtx.tasks = nullptr;
+		if (tasks.size() >= 4 * numOfThreads || splitDepth >= ctx.modOrder.size() || (splitDepth > 0 && tasks.size() <= previousNumOfTasks)
+		 || splittingCtx.timedOut)
+			break;
+	}
+
+	std::atomic< uint > sharedBestSize( splittingCtx.bestSize );
+	WorkStealingQueues queues( numOfThreads );
+	for (size_t taskIdx = 0; taskIdx < tasks.size(); ++taskIdx)
+		queues.push( taskIdx % numOfThreads, taskIdx );
+
+	vector< AlgorithmContext > threadCtxs( numOfThreads, ctx );
+	vector< std::thread > threads;
+	for (uint threadIdx = 0; threadIdx < numOfThreads; ++threadIdx)
+	{
+		threads.emplace_back( [ &, threadIdx ]()
+		{
+			AlgorithmContext & threadCtx = threadCtxs[ threadIdx ];
+			threadCtx.exploredStates = TranspositionTable( transpositionTableSize );
+			threadCtx.sharedBestSize = &sharedBestSize;
+			threadCtx.bestSize = sharedBestSize.load();
+
+			size_t taskIdx;
+			while (queues.pop( threadIdx, taskIdx ))
+			{
+				threadCtx.currentState = tasks[ taskIdx ].state;
+				threadCtx.modOrder = tasks[ taskIdx ].modOrder;
+				tryAllEngineerCombinations( threadCtx, tasks[ taskIdx ].position );
+			}
+		});
+	}
+	for (std::thread & thread : threads)
+		thread.join();
+
+	// the threads can still have some worse solutions, from before they learned about the better ones
+	uint bestSize = splittingCtx.bestSize;
+	ctx.timedOut = splittingCtx.timedOut;
+	ctx.openLowerBound = splittingCtx.openLowerBound;
+	for (const AlgorithmContext & threadCtx : threadCtxs)
+	{
+		bestSize = std::min( bestSize, threadCtx.bestSize );
+		ctx.timedOut |= threadCtx.timedOut;
+		ctx.openLowerBound = std::min( ctx.openLowerBound, threadCtx.openLowerBound );
+	}
+
+	ctx.bestSolutions.clear();
+	ctx.bestSize = bestSize;
+	ctx.foundSolution = false;
+	threadCtxs.push_back( move( splittingCtx ) );
+	for (const AlgorithmContext & threadCtx : threadCtxs)
+	{
+		for (size_t idx = 0; idx < threadCtx.bestSolutions.size(); ++idx)
+		{
+			if (threadCtx.bestSolutions.engineers( idx ).size() == bestSize)
+			{
+				ctx.bestSolutions.insert( threadCtx.bestSolutions.engineers( idx ) );
+				ctx.foundSolution = true;
+			}
+		}
+	}
+}
+
+/// Quickly finds some solution, that is probably not the best one, but good enough to be used as an initial bound.
+/** Starting from the engineers already in the \p solution, repeatedly adds the engineer whose requirements give access
+  * to the most still unsatisfied modifications per engineer added, while respecting that each engineer can have only
+  * one modification pinned. Returns false if this approach fails to satisfy all the modifications. */
+bool findGreedySolution( const vector< DesiredModContext > & desiredModContexts, SearchState & solution )
+{
+	const size_t numOfMods = desiredModContexts.size();
+
+	vector< bool > satisfiedMods( numOfMods, false );
+
+	// unpinned mods need just access to an engineer, pinned mods need an engineer who isn't already pinning another mod
+	auto availableCandidates = [&]( const DesiredModContext & modCtx, EngineerSet engineerSet )
+	{
+		EngineerSet candidates = modCtx.engineers & engineerSet;
+		if (modCtx.mod.pinRequired)
+			candidates = candidates - solution.pinnedEngineers;
+		return candidates;
+	};
+
+	size_t numOfSatisfiedMods = 0;
+	while (true)
+	{
+		// first assign all the modifications that can be satisfied by the engineers we already have
+		for (size_t modIdx = 0; modIdx < numOfMods; ++modIdx)
+		{
+			if (satisfiedMods[ modIdx ])
+				continue;
+			EngineerSet candidates = availableCandidates( desiredModContexts[ modIdx ], solution.requiredEngineers );
+			if (!candidates.empty())
+			{
+				EngineerIdx engineerIdx = *candidates.begin();
+				satisfiedMods[ modIdx ] = true;
+				if (desiredModContexts[ modIdx ].mod.pinRequired)
+					solution.pinnedEngineers.insert( engineerIdx );
+				numOfSatisfiedMods += 1;
+			}
+		}
+
+		if (numOfSatisfiedMods == numOfMods)
+			return true;
+
+		// then choose the engineer with the best ratio of newly satisfied mods to newly required engineers
+		EngineerIdx bestEngineerIdx = EngineerIdx::None;
+		uint bestGain = 0, bestCost = 1;
+		for (EngineerIdx engineerIdx = firstEngineerIdx; engineerIdx <= lastEngineerIdx; engineerIdx = inc( engineerIdx ))
+		{
+			EngineerSet addedEngineers = requirementsOf( engineerIdx ) - solution.requiredEngineers;
+			if (addedEngineers.empty())
+				continue;
+
+			uint gain = 0;
+			for (size_t modIdx = 0; modIdx < numOfMods; ++modIdx)
+			{
+				if (!satisfiedMods[ modIdx ]
+				 && !availableCandidates( desiredModContexts[ modIdx ], addedEngineers ).empty())
+				{
+					gain += 1;
+				}
+			}
+
+			uint cost = uint( addedEngineers.size() );
+			if (gain * bestCost > bestGain * cost)
+			{
+				bestEngineerIdx = engineerIdx;
+				bestGain = gain;
+				bestCost = cost;
+			}
+		}
+
+		if (bestEngineerIdx == EngineerIdx::None)
+			return false;  // no engineer can help anymore, the pinned ones must have been used up
+
+		solution.requiredEngineers |= requirementsOf( bestEngineerIdx );
+	}
+}
+
+/// decisions that can be made before the search, because they are the same for all solutions
+struct Presolved
+{
+	/// the request with the duplicate modules merged, this is what the search actually solves
+	vector< DesiredMod > mergedMods;
+
+	/// the modifications that are left for the search to decide
+	vector< DesiredModContext > remainingMods;
+
+	/// engineers that must be in every solution, including all their requirements
+	EngineerSet forcedEngineers;
+
+	/// those of the forced engineers, that must be used for pinning one of the removed modifications
+	EngineerSet forcedPinnedEngineers;
+
+	/// engineers that are interchangeable with respect to the remaining modifications
+	vector< InterchangeableEngineers > interchangeableGroups;
+
+	/// the presolve found out that the requirements are impossible to satisfy
+	bool infeasible = false;
+};
+
+/// Simplifies the modifications before the exponential part of the algorithm starts.
+/** - Duplicate modules are merged into the highest requested grade. An unpinned request is dropped if a pinned one
+  *   of the same module has at least the same grade, because the engineer pinning it will offer it too.
+  * - Engineers who are the only ones offering some modification are committed together with their requirements.
+  *   If the modification is pinned, the engineer can't pin anything else, which can make more engineers forced.
+  * - The modifications decided this way are removed, together with the unpinned ones offered by forced engineers.
+  * - Candidates dominated by other candidates of the same modification are removed.
+  * - Of each group of interchangeable candidates only as many are kept as can be needed at once,
+  *   that is one, or one per pinned modification they offer.
+  * Unless \p onlyBestSize is set, only the first two steps are done and only the modifications decided by the second
+  * one are removed, because the rest can remove solutions that are not of the best size. */
+Presolved presolve( const vector< DesiredModContext > & desiredModContexts, bool onlyBestSize )
+{
+	Presolved presolved;
+
+	// merge duplicate modules, keeping the position of the first occurence
+	vector< DesiredModContext > mergedMods;
+	for (const DesiredModContext & modCtx : desiredModContexts)
+	{
+		auto sameRequest = std::find_if( mergedMods.begin(), mergedMods.end(), [ &modCtx ]( const DesiredModContext & other )
+		{
+			return other.mod.module == modCtx.mod.module && other.mod.pinRequired == modCtx.mod.pinRequired;
+		});
+		if (sameRequest == mergedMods.end())
+			mergedMods.push_back( modCtx );
+		else if (modCtx.mod.grade > sameRequest->mod.grade)
+			*sameRequest = modCtx;
+	}
+	for (const DesiredModContext & pinnedModCtx : mergedMods)
+	{
+		if (!pinnedModCtx.mod.pinRequired)
+			continue;
+		auto isImplied = [ &pinnedModCtx ]( const DesiredModContext & modCtx )
+		{
+			return !modCtx.mod.pinRequired && modCtx.mod.module == pinnedModCtx.mod.module
+			    && modCtx.mod.grade <= pinnedModCtx.mod.grade;
+		};
+		mergedMods.erase( std::remove_if( mergedMods.begin(), mergedMods.end(), isImplied ), mergedMods.end() );
+	}
+	for (const DesiredModContext & modCtx : mergedMods)
+		presolved.mergedMods.push_back( modCtx.mod );
+
+	// commit the engineers that are the only choice, until nothing changes
+	vector< bool > decided( mergedMods.size(), false );
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (size_t modIdx = 0; modIdx < mergedMods.size(); ++modIdx)
+		{
+			const DesiredModContext & modCtx = mergedMods[ modIdx ];
+			if (decided[ modIdx ])
+				continue;
+
+			EngineerSet candidates = modCtx.engineers;
+			if (modCtx.mod.pinRequired)
+				candidates = candidates - presolved.forcedPinnedEngineers;
+
+			if (candidates.empty())
+			{
+				presolved.infeasible = true;  // the only engineers offering it are needed for pinning something else
+				return presolved;
+			}
+			else if (!modCtx.mod.pinRequired && !(candidates & presolved.forcedEngineers).empty() && onlyBestSize)
+			{
+				decided[ modIdx ] = true;  // already offered by a forced engineer
+			}
+			else if (candidates.size() == 1)
+			{
+				EngineerIdx engineerIdx = *candidates.begin();
+				presolved.forcedEngineers |= requirementsOf( engineerIdx );
+				if (modCtx.mod.pinRequired)
+					presolved.forcedPinnedEngineers.insert( engineerIdx );
+				decided[ modIdx ] = true;
+				changed = true;
+			}
+		}
+	}
+
+	for (size_t modIdx = 0; modIdx < mergedMods.size(); ++modIdx)
+	{
+		if (!decided[ modIdx ])
+			presolved.remainingMods.push_back( mergedMods[ modIdx ] );
+	}
+	if (!onlyBestSize)
+		return presolved;
+
+	// Drop the candidates that are dominated already with the forced engineers. For pinned modifications only
+	// the engineers that don't offer any other pinned modification can dominate, since their pin is surely free.
+	vector< EngineerSet > originalCandidates;
+	for (const DesiredModContext & modCtx : presolved.remainingMods)
+		originalCandidates.push_back( modCtx.engineers );
+	for (size_t modIdx = 0; modIdx < presolved.remainingMods.size(); ++modIdx)
+	{
+		DesiredModContext & modCtx = presolved.remainingMods[ modIdx ];
+		EngineerSet freeForPinning;
+		if (modCtx.mod.pinRequired)
+		{
+			EngineerSet competingEngineers = presolved.forcedPinnedEngineers;
+			for (size_t otherIdx = 0; otherIdx < presolved.remainingMods.size(); ++otherIdx)
+				if (otherIdx != modIdx && presolved.remainingMods[ otherIdx ].mod.pinRequired)
+					competingEngineers |= originalCandidates[ otherIdx ];
+			freeForPinning = modCtx.engineers - competingEngineers;
+		}
+		modCtx.engineers = removeDominatedCandidates(
+			modCtx.engineers, presolved.forcedEngineers, modCtx.mod.pinRequired, freeForPinning
+		);
+	}
+
+	// Find the candidates that could be swapped for each other in any solution. Those that other candidates require
+	// can be added to a solution without being chosen for anything, so they can't be swapped.
+	EngineerSet allCandidates, candidateRequirements;
+	for (const DesiredModContext & modCtx : presolved.remainingMods)
+	{
+		allCandidates |= modCtx.engineers;
+		for (EngineerIdx engineerIdx : modCtx.engineers)
+		{
+			EngineerSet requirements = requirementsOf( engineerIdx );
+			requirements.erase( engineerIdx );
+			candidateRequirements |= requirements;
+		}
+	}
+	auto areInterchangeable = [ &presolved ]( EngineerIdx engineer1, EngineerIdx engineer2 )
+	{
+		if (engineers[ engineer1 ].requiredEngineer != engineers[ engineer2 ].requiredEngineer)
+			return false;
+		for (const DesiredModContext & modCtx : presolved.remainingMods)
+			if (modCtx.engineers.contains( engineer1 ) != modCtx.engineers.contains( engineer2 ))
+				return false;
+		return true;
+	};
+	const EngineerSet groupableEngineers = allCandidates - candidateRequirements - presolved.forcedEngineers;
+	EngineerSet groupedEngineers;
+	for (EngineerIdx engineerIdx : groupableEngineers)
+	{
+		if (groupedEngineers.contains( engineerIdx ))
+			continue;
+
+		InterchangeableEngineers group;
+		for (EngineerIdx otherIdx : groupableEngineers - groupedEngineers)
+			if (areInterchangeable( engineerIdx, otherIdx ))
+				group.members.insert( otherIdx );
+		groupedEngineers |= group.members;
+
+		// one member is enough for all unpinned modifications, but every pinned one needs a different member
+		size_t numOfPinnedMods = 0;
+		for (const DesiredModContext & modCtx : presolved.remainingMods)
+			if (modCtx.mod.pinRequired && modCtx.engineers.contains( engineerIdx ))
+				numOfPinnedMods += 1;
+		const size_t numOfNeeded = std::max( numOfPinnedMods, size_t(1) );
+		for (EngineerIdx memberIdx : group.members)
+			if (group.searched.size() < numOfNeeded)
+				group.searched.insert( memberIdx );
+		if (group.searched == group.members)
+			continue;
+
+		const EngineerSet omittedEngineers = group.members - group.searched;
+		for (DesiredModContext & modCtx : presolved.remainingMods)
+			modCtx.engineers = modCtx.engineers - omittedEngineers;
+		presolved.interchangeableGroups.push_back( group );
+	}
+
+	return presolved;
+}
+
+/// only a wrapper around the recursive function, performing required initialization
+SolutionPool findBestEngineerCombination( const Presolved & presolved, const SearchOptions & options, SearchReport & report )
+{
+	const vector< DesiredModContext > & desiredModContexts = presolved.remainingMods;
+
+	AlgorithmContext ctx;
+
+	ctx.options = options;
+	ctx.bestSolutions = SolutionPool();
+	ctx.interchangeableGroups = presolved.interchangeableGroups;
+	ctx.firstModCtx = desiredModContexts.data();
+	ctx.currentState.requiredEngineers = presolved.forcedEngineers;
+	ctx.currentState.pinnedEngineers = presolved.forcedPinnedEngineers;
+	ctx.currentState.pinMatching.resize( desiredModContexts.size(), EngineerIdx::None );
+	ctx.trail.reserve( 8 * desiredModContexts.size() );  // only few variables are changed on each level
+	ctx.deadline = std::chrono::steady_clock::now() + options.timeBudget;
+	ctx.foundSolution = false;
+
+	// The search keeps a different engineer for each pinned modification, if there isn't such matching even now,
+	// the requirements can't be satisfied.
+	for (size_t modIdx = 0; modIdx < desiredModContexts.size(); ++modIdx)
+	{
+		EngineerSet visitedEngineers;
+		if (desiredModContexts[ modIdx ].mod.pinRequired && !findAugmentingPath( ctx, modIdx, visitedEngineers ))
+			return {};
+	}
+
+	// with the matching there can't be more pinned mods than engineers, so they fit into the 64 bits
+	const bool kBestMode = options.numOfBestSolutions != 0;
+	ctx.pinnedModBits.resize( desiredModContexts.size(), 0 );
+	uint numOfPinnedMods = 0;
+	for (size_t modIdx = 0; modIdx < desiredModContexts.size() && numOfPinnedMods < 64; ++modIdx)
+		if (desiredModContexts[ modIdx ].mod.pinRequired || kBestMode)
+			ctx.pinnedModBits[ modIdx ] = uint64_t(1) << numOfPinnedMods++;
+	ctx.useExploredStates = !kBestMode || desiredModContexts.size() <= 64;
+	ctx.exploredStates = TranspositionTable( options.transpositionTableSize );
+
+	// Decide the most constrained modifications first, so that the branching is small at the top of the recursion
+	// and the dead ends are discovered early. Pinned modifications are the most constrained, because they compete
+	// for the engineers, then the ones with the fewest engineers offering them.
+	for (const DesiredModContext & modCtx : desiredModContexts)
+		ctx.modOrder.push_back( &modCtx );
+	std::stable_sort( ctx.modOrder.begin(), ctx.modOrder.end(), []( const DesiredModContext * a, const DesiredModContext * b )
+	{
+		if (a->mod.pinRequired != b->mod.pinRequired)
+			return a->mod.pinRequired;
+		return a->engineers.size() < b->engineers.size();
+	});
+
+	// Start with the size of a quickly found solution, so that the search can prune from the very beginning.
+	// The exhaustive search will find that solution again (or a better one), so it doesn't need to be stored.
+	SearchState greedySolution = ctx.currentState;
+	const bool foundGreedySolution = findGreedySolution( desiredModContexts, greedySolution );
+	if (foundGreedySolution && !kBestMode)  // in the k-best mode the bound is known only when there are enough solutions
+		ctx.bestSize = uint( greedySolution.requiredEngineers.size() );
+	else
+		ctx.bestSize = unreachable;
+
+	const uint additionalEngineers = estimateAdditionalEngineers( ctx, 0, unreachable - 1 );
+	if (additionalEngineers == unreachable)
+		return {};  // some pinned modification can't get its own engineer, so there is no solution at all
+	const uint rootLowerBound = uint( ctx.currentState.requiredEngineers.size() ) + additionalEngineers;
+
+	if (kBestMode)
+		tryAllEngineerCombinations( ctx, 0 );
+	else if (!options.checkpointFileName.empty())
+		searchResumably( ctx, report );
+	else if (options.numOfThreads > 1)
+		searchInParallel( ctx, options.numOfThreads );
+	else
+		tryAllEngineerCombinations( ctx, 0 );
+
+	if (ctx.timedOut)
+	{
+		report.timeBudgetExceeded = true;
+
+		// the search didn't get to any solution as good as the greedy one, so that one is still the best known
+		if (ctx.bestSolutions.empty() && ctx.kBestSolutions.empty() && foundGreedySolution)
+		{
+			ctx.currentState = move( greedySolution );
+			addSolution( ctx, ctx.currentState.requiredEngineers );
+		}
+
+		// The subtrees the search didn't get to are the only place where a better solution can be.
+		// The estimate isn't monotonic, so the one of the whole tree can still be better than theirs.
+		report.lowerBound = std::max( rootLowerBound, std::min( ctx.openLowerBound, ctx.bestSize ) );
+	}
+
+	for (EngineerSet engineerSet : ctx.kBestSolutions)
+		ctx.bestSolutions.insert( engineerSet );
+
+	if (ctx.foundSolution)
+		return move( ctx.bestSolutions );
+	else
+		return {};  // because empty set can never be a valid result, we can use this to indicate failure
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+//  tree DP engine
+//
+//  Each engineer requires at most one other engineer, so the requirements form a forest, and a valid set of engineers
+//  is a sub-forest containing the roots of its trees. Going through the engineers in the preorder of the forest,
+//  each engineer is either included, or skipped together with his whole subtree. The state is then just the position
+//  in the preorder and the set of modifications covered so far, so the work is polynomial in the number of engineers
+//  and exponential only in the number of modifications, no matter how many combinations the recursive search
+//  would have to go through.
+
+/// Lists the engineers in the preorder of the requirement forest, children after their parent,
+/// siblings in the order of their indexes.
+/** \p subtreeEnd receives for each position the position right after the subtree of the engineer there. */
+void buildRequirementPreorder( vector< EngineerIdx > & preorder, vector< size_t > & subtreeEnd )
+{
+	IndexMap< EngineerIdx, EngineerIdx::_EndOfEnum, EngineerList > successors;
+	EngineerList roots;
+	for (EngineerIdx engineerIdx = firstEngineerIdx; engineerIdx <= lastEngineerIdx; engineerIdx = inc( engineerIdx ))
+	{
+		EngineerIdx predecessor = engineers[ engineerIdx ].requiredEngineer;
+		if (predecessor != EngineerIdx::None)
+			successors[ predecessor ].push_back( engineerIdx );
+		else
+			roots.push_back( engineerIdx );
+	}
+
+	auto addSubtree = [ & ]( EngineerIdx engineerIdx, auto & addSubtree ) -> void
+	{
+		size_t pos = preorder.size();
+		preorder.push_back( engineerIdx );
+		subtreeEnd.push_back( 0 );
+		for (EngineerIdx successor : successors[ engineerIdx ])
+			addSubtree( successor, addSubtree );
+		subtreeEnd[ pos ] = preorder.size();
+	};
+	for (EngineerIdx rootIdx : roots)
+		addSubtree( rootIdx, addSubtree );
+}
+
+/// intermediate results and support data of the tree DP
+struct TreeDPContext
+{
+	const Presolved & presolved;
+
+	/// engineers in the preorder of the requirement forest
+	vector< EngineerIdx > preorder;
+
+	/// for each position in the preorder, the position right after the subtree of the engineer there
+	vector< size_t > subtreeEnd;
+
+	/// for each position in the preorder, the unpinned mods covered by including the engineer there
+	vector< uint64_t > coveredMods;
+
+	/// for each position in the preorder, the pinned mods the engineer there can pin
+	vector< uint64_t > pinnableMods;
+
+	/// for each position in the preorder, all the mods that the engineers from there on can satisfy
+	vector< uint64_t > reachableMods;
+
+	/// the mods that need to be covered, one bit per DesiredModContext
+	uint64_t allMods;
+
+	/// For each position in the preorder and set of covered mods, the fewest engineers needed to cover the rest.
+	/** The forced engineers are not counted, they are in every solution anyway. */
+	vector< unordered_map< uint64_t, uint8_t > > memo;
+};
+
+static constexpr uint8_t unreachableByDP = uint8_t(-1);
+
+/// Computes the fewest engineers that need to be included from the position \p pos on to cover all the mods.
+uint8_t fewestEngineersToFinish( TreeDPContext & ctx, size_t pos, uint64_t coveredMods )
+{
+	if (coveredMods == ctx.allMods)
+		return 0;  // there is no point in including more engineers, and the forced ones are already done
+	if ((coveredMods | ctx.reachableMods[ pos ]) != ctx.allMods)
+		return unreachableByDP;
+
+	auto memoIter = ctx.memo[ pos ].find( coveredMods );
+	if (memoIter != ctx.memo[ pos ].end())
+		return memoIter->second;
+
+	const EngineerIdx engineerIdx = ctx.preorder[ pos ];
+	uint8_t fewest = unreachableByDP;
+	auto consider = [ &fewest ]( uint8_t numOfEngineers, uint8_t added )
+	{
+		if (numOfEngineers != unreachableByDP)
+			fewest = std::min( fewest, uint8_t( numOfEngineers + added ) );
+	};
+
+	// skip the engineer together with everybody who requires him
+	if (!ctx.presolved.forcedEngineers.contains( engineerIdx ))
+		consider( fewestEngineersToFinish( ctx, ctx.subtreeEnd[ pos ], coveredMods ), 0 );
+
+	// or include him, and optionally let him pin one of the mods
+	const uint8_t added = ctx.presolved.forcedEngineers.contains( engineerIdx ) ? 0 : 1;
+	const uint64_t coveredWithEngineer = coveredMods | ctx.coveredMods[ pos ];
+	consider( fewestEngineersToFinish( ctx, pos + 1, coveredWithEngineer ), added );
+	for (uint64_t pinnable = ctx.pinnableMods[ pos ] & ~coveredWithEngineer; pinnable != 0; pinnable &= pinnable - 1)
+		consider( fewestEngineersToFinish( ctx, pos + 1, coveredWithEngineer | (pinnable & -pinnable) ), added );
+
+	ctx.memo[ pos ][ coveredMods ] = fewest;
+	return fewest;
+}
+
+/// Follows all the choices that lead to the fewest engineers, and adds the resulting sets of engineers to \p solutions.
+void collectBestSolutions(
+	TreeDPContext & ctx, size_t pos, uint64_t coveredMods, EngineerSet engineerSet, SolutionPool & solutions
+)
+{
+	const uint8_t fewest = fewestEngineersToFinish( ctx, pos, coveredMods );
+	if (fewest == 0)
+	{
+		// the engineers that are required anyway are added now
+		engineerSet |= ctx.presolved.forcedEngineers;
+		solutions.insert( normalizeInterchangeable( engineerSet, ctx.presolved.interchangeableGroups ) );
+		return;
+	}
+
+	const EngineerIdx engineerIdx = ctx.preorder[ pos ];
+
+	if (!ctx.presolved.forcedEngineers.contains( engineerIdx )
+	 && fewestEngineersToFinish( ctx, ctx.subtreeEnd[ pos ], coveredMods ) == fewest)
+	{
+		collectBestSolutions( ctx, ctx.subtreeEnd[ pos ], coveredMods, engineerSet, solutions );
+	}
+
+	engineerSet.insert( engineerIdx );
+	const uint8_t added = ctx.presolved.forcedEngineers.contains( engineerIdx ) ? 0 : 1;
+	const uint64_t coveredWithEngineer = coveredMods | ctx.coveredMods[ pos ];
+	if (fewestEngineersToFinish( ctx, pos + 1, coveredWithEngineer ) + added == fewest)
+	{
+		collectBestSolutions( ctx, pos + 1, coveredWithEngineer, engineerSet, solutions );
+	}
+	for (uint64_t pinnable = ctx.pinnableMods[ pos ] & ~coveredWithEngineer; pinnable != 0; pinnable &= pinnable - 1)
+	{
+		const uint64_t pinnedMod = pinnable & -pinnable;
+		if (fewestEngineersToFinish( ctx, pos + 1, coveredWithEngineer | pinnedMod ) + added == fewest)
+		{
+			collectBestSolutions( ctx, pos + 1, coveredWithEngineer | pinnedMod, engineerSet, solutions );
+		}
+	}
+}
+
+/// Fills in the tables of the tree DP for the ctx.presolved modifications, of which there can be at most 64.
+void prepareTreeDP( TreeDPContext & ctx )
+{
+	const Presolved & presolved = ctx.presolved;
+	const vector< DesiredModContext > & mods = presolved.remainingMods;
+
+	ctx.allMods = mods.size() == 64 ? ~uint64_t(0) : (uint64_t(1) << mods.size()) - 1;
+
+	buildRequirementPreorder( ctx.preorder, ctx.subtreeEnd );
+
+	const size_t numOfPositions = ctx.preorder.size();
+	ctx.coveredMods.resize( numOfPositions, 0 );
+	ctx.pinnableMods.resize( numOfPositions, 0 );
+	ctx.reachableMods.resize( numOfPositions + 1, 0 );
+	for (size_t pos = 0; pos < numOfPositions; ++pos)
+	{
+		const EngineerIdx engineerIdx = ctx.preorder[ pos ];
+		for (size_t modIdx = 0; modIdx < mods.size(); ++modIdx)
+		{
+			if (!mods[ modIdx ].engineers.contains( engineerIdx ))
+				continue;
+			if (!mods[ modIdx ].mod.pinRequired)
+				ctx.coveredMods[ pos ] |= uint64_t(1) << modIdx;
+			else if (!presolved.forcedPinnedEngineers.contains( engineerIdx ))
+				ctx.pinnableMods[ pos ] |= uint64_t(1) << modIdx;
+		}
+	}
+	for (size_t pos = numOfPositions; pos-- > 0;)
+		ctx.reachableMods[ pos ] = ctx.reachableMods[ pos + 1 ] | ctx.coveredMods[ pos ] | ctx.pinnableMods[ pos ];
+	ctx.memo.resize( numOfPositions + 1 );
+}
+
+/// Finds the same solutions as findBestEngineerCombination(), but using the tree DP.
+SolutionPool findBestEngineerCombinationByTreeDP( const Presolved & presolved, const SearchOptions & options, SearchReport & report )
+{
+	const vector< DesiredModContext > & mods = presolved.remainingMods;
+	if (mods.size() > 64)
+		return findBestEngineerCombination( presolved, options, report );  // the covered mods wouldn't fit into the mask
+
+	TreeDPContext ctx { presolved, {}, {}, {}, {}, {}, 0, {} };
+	prepareTreeDP( ctx );
+
+	if (fewestEngineersToFinish( ctx, 0, 0 ) == unreachableByDP)
+		return {};
+
+	SolutionPool solutions;
+	collectBestSolutions( ctx, 0, 0, EngineerSet(), solutions );
+	return solutions;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+//  counting the best solutions
+//
+//  The paths through the choices of the tree DP that lead to the fewest engineers can end with the same set
+//  of engineers, when only the choice which engineer pins which modification differs. So the counting walks only
+//  the choices to include or skip each engineer, which gives every set exactly once, and instead of the pinned mods
+//  covered so far it keeps what the included engineers can pin. The best solutions are then counted without keeping
+//  the sets in memory. Only the first few sets, that are to be shown, are kept.
+
+/// the numbers of all the best solutions, and the first ones of them
+struct SolutionCount
+{
+	uint64_t numOfEngineerSets = 0;
+
+	/// number of ways to choose an engineer offering each modification, with different engineers for the pinned ones,
+	/// summed over all the sets of engineers, stops at the maximum of uint64_t
+	uint64_t numOfAssignments = 0;
+
+	/// the lexicographically first of the sets, ordered as a heap with the greatest on the top
+	vector< EngineerSet > firstEngineerSets;
+};
+
+inline uint64_t saturatingAdd( uint64_t a, uint64_t b )  { return a > UINT64_MAX - b ? UINT64_MAX : a + b; }
+inline uint64_t saturatingMul( uint64_t a, uint64_t b )  { return b != 0 && a > UINT64_MAX / b ? UINT64_MAX : a * b; }
+
+/// Counts the different choices of an engineer from a set for each of the modifications.
+/** The unpinned modifications can choose independently, so only the pinned ones need to be counted together,
+  * with the number of ways to finish remembered for each modification and set of already pinned engineers.
+  * The buffers are kept between the calls, so that counting many sets doesn't allocate for each of them. */
+class AssignmentCounter
+{
+	vector< EngineerSet > pinnedModCandidates;
+	unordered_map< uint64_t, uint64_t > memo;
+
+	uint64_t countPinnings( size_t modIdx, EngineerSet pinnedEngineers )
+	{
+		if (modIdx == pinnedModCandidates.size())
+			return 1;
+
+		const uint64_t stateKey = (uint64_t( pinnedEngineers.mask() ) << 32) | modIdx;
+		auto memoIter = memo.find( stateKey );
+		if (memoIter != memo.end())
+			return memoIter->second;
+
+		uint64_t count = 0;
+		for (EngineerIdx engineerIdx : pinnedModCandidates[ modIdx ] - pinnedEngineers)
+		{
+			EngineerSet newPinnedEngineers = pinnedEngineers;
+			newPinnedEngineers.insert( engineerIdx );
+			count = saturatingAdd( count, countPinnings( modIdx + 1, newPinnedEngineers ) );
+		}
+		memo[ stateKey ] = count;
+		return count;
+	}
+
+ public:
+
+	uint64_t count( const vector< DesiredMod > & mods, EngineerSet engineerSet )
+	{
+		uint64_t numOfAssignments = 1;
+		pinnedModCandidates.clear();
+		for (const DesiredMod & mod : mods)
+		{
+			EngineerSet candidates = findEngineersOfferingModification( mod ) & engineerSet;
+			if (mod.pinRequired)
+				pinnedModCandidates.push_back( candidates );
+			else
+				numOfAssignments = saturatingMul( numOfAssignments, candidates.size() );
+		}
+
+		memo.clear();
+		return saturatingMul( numOfAssignments, countPinnings( 0, EngineerSet() ) );
+	}
+};
+
+/// support data for countBestEngineerCombinations()
+/** What the included engineers can pin is kept as the largest sets of the pinned mods that they can pin all at once,
+  * each mod by a different engineer. They all have the same size, because the sets that can be pinned at once form
+  * a matroid. Including another engineer extends each of them by each mod he can pin and that isn't in it already,
+  * and if there is none such, the sets stay the same. The fewest engineers needed to finish from a position is then
+  * the fewest of the tree DP over these sets, so the walk doesn't need to choose who pins what, and it's still never
+  * led into a choice that doesn't end with one of the best sets. */
+struct BestSolutionCounting
+{
+	TreeDPContext & ctx;
+	const vector< DesiredMod > & allMods;
+	size_t maxSolutions;
+	SolutionCount & count;
+
+	/// the largest sets of pinned mods that can be pinned at once, for each number of the pinned mods in them
+	/** Each level of the walk only reads its own list, so that the lists are allocated only once. */
+	vector< vector< uint64_t > > pinnableSets;
+
+	AssignmentCounter assignmentCounter;
+
+	/// the fewest engineers needed to finish from the position \p pos, when any of the \p pinnable sets can be pinned
+	uint8_t fewestToFinish( size_t pos, uint64_t coveredMods, const vector< uint64_t > & pinnable )
+	{
+		uint8_t fewest = unreachableByDP;
+		for (uint64_t pinnedMods : pinnable)
+			fewest = std::min( fewest, fewestEngineersToFinish( ctx, pos, coveredMods | pinnedMods ) );
+		return fewest;
+	}
+
+	/// Walks all the choices that lead to the fewest engineers like collectBestSolutions(), and counts the sets.
+	void countFrom( size_t pos, uint64_t coveredMods, size_t numOfPinned, EngineerSet engineerSet )
+	{
+		const uint8_t fewest = fewestToFinish( pos, coveredMods, pinnableSets[ numOfPinned ] );
+		if (fewest == 0)
+		{
+			engineerSet |= ctx.presolved.forcedEngineers;
+			addEngineerSet( engineerSet );
+			return;
+		}
+
+		const EngineerIdx engineerIdx = ctx.preorder[ pos ];
+
+		if (!ctx.presolved.forcedEngineers.contains( engineerIdx )
+		 && fewestToFinish( ctx.subtreeEnd[ pos ], coveredMods, pinnableSets[ numOfPinned ] ) == fewest)
+		{
+			countFrom( ctx.subtreeEnd[ pos ], coveredMods, numOfPinned, engineerSet );
+		}
+
+		// if the engineer can extend the largest pinnable sets, the extended ones replace them
+		if (pinnableSets.size() < numOfPinned + 2)
+			pinnableSets.resize( numOfPinned + 2 );
+		vector< uint64_t > & extended = pinnableSets[ numOfPinned + 1 ];
+		extended.clear();
+		for (uint64_t pinnedMods : pinnableSets[ numOfPinned ])
+			for (uint64_t pinnable = ctx.pinnableMods[ pos ] & ~pinnedMods; pinnable != 0; pinnable &= pinnable - 1)
+				extended.push_back( pinnedMods | (pinnable & -pinnable) );
+		std::sort( extended.begin(), extended.end() );
+		extended.erase( std::unique( extended.begin(), extended.end() ), extended.end() );
+		const size_t newNumOfPinned = extended.empty() ? numOfPinned : numOfPinned + 1;
+
+		engineerSet.insert( engineerIdx );
+		const uint8_t added = ctx.presolved.forcedEngineers.contains( engineerIdx ) ? 0 : 1;
+		const uint64_t coveredWithEngineer = coveredMods | ctx.coveredMods[ pos ];
+		if (fewestToFinish( pos + 1, coveredWithEngineer, pinnableSets[ newNumOfPinned ] ) + added == fewest)
+		{
+			countFrom( pos + 1, coveredWithEngineer, newNumOfPinned, engineerSet );
+		}
+	}
+
+	void addEngineerSet( EngineerSet engineerSet )
+	{
+		count.numOfEngineerSets += 1;
+		count.numOfAssignments = saturatingAdd( count.numOfAssignments, assignmentCounter.count( allMods, engineerSet ) );
+
+		if (count.firstEngineerSets.size() < maxSolutions)
+		{
+			count.firstEngineerSets.push_back( engineerSet );
+			std::push_heap( count.firstEngineerSets.begin(), count.firstEngineerSets.end() );
+		}
+		else if (maxSolutions > 0 && engineerSet < count.firstEngineerSets.front())
+		{
+			std::pop_heap( count.firstEngineerSets.begin(), count.firstEngineerSets.end() );
+			count.firstEngineerSets.back() = engineerSet;
+			std::push_heap( count.firstEngineerSets.begin(), count.firstEngineerSets.end() );
+		}
+	}
+};
+
+/// Counts all the best solutions of the \p allMods, with every choice between interchangeable engineers counted
+/// separately, and keeps the first \p maxSolutions of them. Returns false if there are too many modifications left
+/// after the presolve for the tree DP.
+/** Each of the best sets is visited once, so the time grows with their number, but not with the number of ways
+  * to pin the mods within them. */
+bool countBestEngineerCombinations(
+	const Presolved & presolved, const vector< DesiredMod > & allMods, size_t maxSolutions, SolutionCount & count
+)
+{
+	if (presolved.remainingMods.size() > 64)
+		return false;
+
+	// the members of the interchangeable groups that the presolve removed are counted as any other engineers
+	Presolved expanded = presolved;
+	for (const InterchangeableEngineers & group : expanded.interchangeableGroups)
+		for (DesiredModContext & modCtx : expanded.remainingMods)
+			if (!(modCtx.engineers & group.searched).empty())
+				modCtx.engineers |= group.members;
+	expanded.interchangeableGroups.clear();
+
+	TreeDPContext ctx { expanded, {}, {}, {}, {}, {}, 0, {} };
+	prepareTreeDP( ctx );
+
+	if (fewestEngineersToFinish( ctx, 0, 0 ) != unreachableByDP)
+	{
+		// at first nothing is included, so only the empty set can be pinned
+		BestSolutionCounting counting { ctx, allMods, maxSolutions, count, { { 0 } }, {} };
+		counting.countFrom( 0, 0, 0, EngineerSet() );
+	}
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+//  meet-in-the-middle engine
+//
+//  The modifications are split into two halves and each half is enumerated separately, keeping only the distinct
+//  pairs of (required engineers, pinned engineers) it can end with. The number of these states is roughly the square
+//  root of the number of combinations the recursive search would go through. The best solutions are then the smallest
+//  unions of a state from each half whose pinned engineers don't overlap.
+
+/// support data for enumerating the states one half of the modifications can end with
+struct HalfEnumeration
+{
+	vector< const DesiredModContext * > mods;
+
+	/// states already reached at each position, so that their continuations are not enumerated twice
+	vector< unordered_set< uint64_t > > visitedStates;
+
+	/// the distinct states at the end, the required engineers in the high half, the newly pinned ones in the low
+	unordered_set< uint64_t > finalStates;
+
+	size_t numOfStoredStates = 0;
+	size_t maxStoredStates = 0;
+
+	static uint64_t stateKey( EngineerSet requiredEngineers, EngineerSet pinnedEngineers )
+	{
+		return (uint64_t( requiredEngineers.mask() ) << 32) | pinnedEngineers.mask();
+	}
+
+	/// Chooses an engineer for the modification at \p pos and continues with the next one.
+	/** Returns false when the number of stored states exceeds the limit. */
+	bool enumerateFrom( size_t pos, EngineerSet requiredEngineers, EngineerSet pinnedEngineers, EngineerSet forbiddenPins )
+	{
+		if (pos == mods.size())
+		{
+			numOfStoredStates += finalStates.insert( stateKey( requiredEngineers, pinnedEngineers ) ).second;
+			return numOfStoredStates <= maxStoredStates;
+		}
+
+		if (!visitedStates[ pos ].insert( stateKey( requiredEngineers, pinnedEngineers ) ).second)
+			return true;
+		numOfStoredStates += 1;
+		if (numOfStoredStates > maxStoredStates)
+			return false;
+
+		const DesiredModContext * modCtx = mods[ pos ];
+		if (!modCtx->mod.pinRequired && !(modCtx->engineers & requiredEngineers).empty())
+			return enumerateFrom( pos + 1, requiredEngineers, pinnedEngineers, forbiddenPins );
+
+		EngineerSet candidates = modCtx->engineers;
+		if (modCtx->mod.pinRequired)
+			candidates = candidates - pinnedEngineers - forbiddenPins;
+		for (EngineerIdx engineerIdx : candidates)
+		{
+			EngineerSet newPinnedEngineers = pinnedEngineers;
+			if (modCtx->mod.pinRequired)
+				newPinnedEngineers.insert( engineerIdx );
+			if (!enumerateFrom( pos + 1, requiredEngineers | requirementsOf( engineerIdx ), newPinnedEngineers, forbiddenPins ))
+				return false;
+		}
+		return true;
+	}
+
+	/// approximate memory taken by the hash tables
+	size_t memoryUsed() const
+	{
+		// every stored key is in a separate node together with a pointer to the next one and its hash
+		const size_t bytesPerNode = sizeof(uint64_t) + sizeof(void *) + sizeof(size_t);
+		size_t bytes = finalStates.size() * bytesPerNode + finalStates.bucket_count() * sizeof(void *);
+		for (const auto & states : visitedStates)
+			bytes += states.size() * bytesPerNode + states.bucket_count() * sizeof(void *);
+		return bytes;
+	}
+};
+
+/// Finds the same solutions as findBestEngineerCombination(), but using the meet-in-the-middle.
+/** If the tables would need more memory than SearchOptions::memoryLimit, it falls back to the depth-first search. */
+SolutionPool findBestEngineerCombinationByMeetInTheMiddle(
+	const Presolved & presolved, const SearchOptions & options, SearchReport & report
+)
+{
+	const vector< DesiredModContext > & desiredModContexts = presolved.remainingMods;
+
+	// Split the modifications so that both halves have about the same number of combinations. The constrained ones
+	// go first, so that the halves run out of the pinned engineers as early as possible.
+	vector< const DesiredModContext * > sortedMods;
+	for (const DesiredModContext & modCtx : desiredModContexts)
+		sortedMods.push_back( &modCtx );
+	std::stable_sort( sortedMods.begin(), sortedMods.end(), []( const DesiredModContext * a, const DesiredModContext * b )
+	{
+		if (a->mod.pinRequired != b->mod.pinRequired)
+			return a->mod.pinRequired;
+		return a->engineers.size() < b->engineers.size();
+	});
+	HalfEnumeration halves [2];
+	double combinations [2] = { 1.0, 1.0 };
+	for (const DesiredModContext * modCtx : sortedMods)
+	{
+		int smallerHalf = combinations[0] <= combinations[1] ? 0 : 1;
+		halves[ smallerHalf ].mods.push_back( modCtx );
+		combinations[ smallerHalf ] *= double( modCtx->engineers.size() );
+	}
+
+	// the pins of the forced engineers are not stored in the states, they would only collide in every join
+	const size_t bytesPerState = sizeof(uint64_t) + sizeof(void *) + sizeof(size_t);
+	bool withinLimit = true;
+	for (HalfEnumeration & half : halves)
+	{
+		half.visitedStates.resize( half.mods.size() );
+		half.maxStoredStates = options.memoryLimit / bytesPerState / 2;
+		withinLimit = withinLimit
+		           && half.enumerateFrom( 0, presolved.forcedEngineers, EngineerSet(), presolved.forcedPinnedEngineers );
+		report.numOfStoredStates += half.numOfStoredStates;
+		report.memoryUsed += half.memoryUsed();
+		half.visitedStates.clear();  // not needed for the join
+	}
+	if (!withinLimit)
+	{
+		report.memoryLimitExceeded = true;
+		return findBestEngineerCombination( presolved, options, report );
+	}
+
+	// The union is at least as big as the bigger of the two sets, so when the states of the second half are ordered
+	// by size, the join can stop as soon as they get bigger than the best solution.
+	auto sizeOf = []( uint64_t state ) { return popCount( uint32_t( state >> 32 ) ); };
+	vector< uint64_t > firstStates( halves[0].finalStates.begin(), halves[0].finalStates.end() );
+	vector< uint64_t > secondStates( halves[1].finalStates.begin(), halves[1].finalStates.end() );
+	auto bySize = [ &sizeOf ]( uint64_t a, uint64_t b ) { return sizeOf( a ) < sizeOf( b ); };
+	std::sort( firstStates.begin(), firstStates.end(), bySize );
+	std::sort( secondStates.begin(), secondStates.end(), bySize );
+
+	SolutionPool solutions;
+	uint bestSize = unreachable;
+	for (uint64_t firstState : firstStates)
+	{
+		if (sizeOf( firstState ) > bestSize)
+			break;
+		for (uint64_t secondState : secondStates)
+		{
+			if (sizeOf( secondState ) > bestSize)
+				break;
+			if ((uint32_t( firstState ) & uint32_t( secondState )) != 0)
+				continue;  // the same engineer would have to pin two modifications
+
+			EngineerSet solutionEngineers( EngineerMask( (firstState | secondState) >> 32 ) );
+			uint currentSize = uint( solutionEngineers.size() );
+			if (currentSize < bestSize)
+			{
+				solutions.clear();
+				bestSize = currentSize;
+			}
+			if (currentSize == bestSize)
+			{
+				EngineerSet normalized = normalizeInterchangeable( solutionEngineers, presolved.interchangeableGroups );
+				solutions.insert( normalized );
+			}
+		}
+	}
+
+	return solutions;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+//  table of closed engineer sets
+//
+//  The requirement forest is small enough that all the sets of engineers containing the requirements of their members
+//  can be listed, there are less than 200 thousand of them. So they can be enumerated just once, together with the best
+//  grade of each module they give access to, ordered by their size and stored to a file. A request without pins is then
+//  answered by scanning the table from the smallest sets, until they get bigger than the first one offering everything.
 
-/// Removes all engineers that are required to be unlocked to unlock this engineer, including this engineer himself.
-void removeEngineerWithAllRequirements( EngineerIdx engineerIdx, EngineerSet & requiredEngineers )
+/// all closed sets of engineers, with the modifications they offer
+class ClosedSetTable
 {
-	EngineerIdx currentEngineerIdx = engineerIdx;
-	while (currentEngineerIdx != EngineerIdx::None)
+	static constexpr char fileMagic [4] = { 'E', 'D', 'S', 'T' };
+	static constexpr uint32_t fileVersion = 1;
+
+	/// packed grade vectors, see the SIMD kernels
+	static constexpr size_t bytesPerRecord = packedGradeVectorSize;
+
+	/// the kernels read whole registers, so the last vector must be followed by some readable memory
+	static constexpr size_t padding = 32 - bytesPerRecord;
+
+	vector< EngineerSet > engineerSets;  ///< ordered by size, and then lexicographically
+	vector< uint8_t > packedGrades;  ///< the best offered grade of each module, bytesPerRecord per engineer set + padding
+
+	/// Identifies the engineer database, so that a table built from a different one is not used.
+	/** FNV-1a hash of everything the table is derived from. */
+	static uint64_t databaseHash()
 	{
-		requiredEngineers.erase( currentEngineerIdx );
-		currentEngineerIdx = engineers[ currentEngineerIdx ].requiredEngineer;
+		uint64_t hash = 0xCBF29CE484222325u;
+		auto addByte = [ &hash ]( uint8_t byte ) { hash = (hash ^ byte) * 0x100000001B3u; };
+		for (EngineerIdx engineerIdx = firstEngineerIdx; engineerIdx <= lastEngineerIdx; engineerIdx = inc( engineerIdx ))
+		{
+			for (size_t byteIdx = 0; byteIdx < sizeof(EngineerMask); ++byteIdx)
+				addByte( uint8_t( requirementClosures[ engineerIdx ] >> (8 * byteIdx) ) );
+			for (size_t moduleIdx = 0; moduleIdx < numOfModules; ++moduleIdx)
+				addByte( uint8_t( offeredGrades[ engineerIdx ][ moduleIdx ] ) );
+		}
+		return hash;
 	}
-}
 
-/// Removes an engineer from all the sets of engineers offering a mod that is required to be pinned
-void removeEngineerFromAllSetsOfPinnedMods( EngineerIdx engineerIdx, DesiredModContext * currentModCtx, DesiredModContext * lastModCtx )
-{
-	while (currentModCtx <= lastModCtx)
+ public:
+
+	size_t size() const  { return engineerSets.size(); }
+
+	const EngineerSet & engineers( size_t idx ) const  { return engineerSets[ idx ]; }
+
+	/// index right after the last engineer set of the given size
+	size_t endOfSize( size_t numOfEngineers ) const
 	{
-		if (currentModCtx->mod.pinRequired)
-			currentModCtx->engineers.erase( engineerIdx );
-		++currentModCtx;
+		return size_t( std::partition_point( engineerSets.begin(), engineerSets.end(), [ numOfEngineers ]( const EngineerSet & engineerSet )
+		{
+			return engineerSet.size() <= numOfEngineers;
+		}) - engineerSets.begin() );
 	}
-}
 
-/// Re-inserts an engineer to all the sets of engineers offering a mod that is required to be pinned
-void addEngineerToAllSetsOfPinnedMods( EngineerIdx engineerIdx, DesiredModContext * currentModCtx, DesiredModContext * lastModCtx )
-{
-	while (currentModCtx <= lastModCtx)
+	/// Returns the index of the first engineer set between \p begin and \p end that gives access to all
+	/// the modifications whose grades are in the packed grade vector \p wanted, or \p end if there is none.
+	size_t findFirstOffering( size_t begin, size_t end, const uint8_t * wanted ) const
 	{
-		if (currentModCtx->mod.pinRequired)
-			currentModCtx->engineers.insert( engineerIdx );
-		++currentModCtx;
+		return simdKernels().findFirstOffering( packedGrades.data(), bytesPerRecord, begin, end, wanted );
 	}
-}
 
-/// The core of the algorithm, recursive function.
-/** \param ctx                 intermediate results for the algorithm
-  * \param currentEngineerSet  set of engineers offering the current modification
-  * \param lastEngineerSet     set of engineers offering the last modification
-  * Executes one level of dynamic cascade of nested for-loops that generates all combinations of engineers from
-  * the given engineer sets, and calculates how many other engineers need to be unlocked to get access
-  * to these engineers in these sets. */
-void tryAllEngineerCombinations( AlgorithmContext & ctx, DesiredModContext * currentModCtx, DesiredModContext * lastModCtx )
-{
-	// If all engineers offering this modification are already used for pinning the previous modifications,
-	// this loop simply performs no iteration and this combination is not finished and evaluated.
-	for (EngineerIdx engineerIdx : currentModCtx->engineers)
+	/// Enumerates all the closed sets of engineers, skipping the subtrees of the requirement forest.
+	void build()
 	{
-		// add all the engineers that are required to be unlocked in order to unlock this one
-		addEngineerWithAllRequirements( engineerIdx, ctx.currentSolution.requiredEngineers );
-		// and link the main engineer to the desired modification
-		ctx.currentSolution.relatedModifications.insert( engineerIdx, currentModCtx->mod );
+		struct Record
+		{
+			EngineerSet engineerSet;
+			grade_t grades [ numOfModules ];
+		};
+		vector< Record > records;
+
+		vector< EngineerIdx > preorder;
+		vector< size_t > subtreeEnd;
+		buildRequirementPreorder( preorder, subtreeEnd );
 
-		if (currentModCtx < lastModCtx)
+		auto addSetsFrom = [ & ]( size_t pos, const Record & current, auto & addSetsFrom ) -> void
 		{
-			// optimization: If it's not better now, it will not be better deeper in the recursion, abort here.
-			if (ctx.bestSolutions.empty() || isBetterOrEqual( ctx.currentSolution, *ctx.bestSolutions.begin() ))
+			if (pos == preorder.size())
 			{
-				// If the current mod is required to be pinned, remove the current engineer from
-				// all the sets of engineers offering another mod that is required to be pinned,
-				// because pinning more modifications from this engineer will not be possible.
-				if (currentModCtx->mod.pinRequired)
-					removeEngineerFromAllSetsOfPinnedMods( engineerIdx, currentModCtx + 1, lastModCtx );
-
-				// continue with generating the rest of the combination
-				tryAllEngineerCombinations( ctx, currentModCtx + 1, lastModCtx );
-
-				// restore the previous state of the sets of engineers offering a mod that is required to be pinned
-				if (currentModCtx->mod.pinRequired)
-					addEngineerToAllSetsOfPinnedMods( engineerIdx, currentModCtx + 1, lastModCtx );
+				records.push_back( current );
+				return;
 			}
+
+			// without the engineer, nobody who requires him can be in the set
+			addSetsFrom( subtreeEnd[ pos ], current, addSetsFrom );
+
+			Record withEngineer = current;
+			withEngineer.engineerSet.insert( preorder[ pos ] );
+			for (size_t moduleIdx = 0; moduleIdx < numOfModules; ++moduleIdx)
+				withEngineer.grades[ moduleIdx ] = std::max( current.grades[ moduleIdx ], offeredGrades[ preorder[ pos ] ][ moduleIdx ] );
+			addSetsFrom( pos + 1, withEngineer, addSetsFrom );
+		};
+		addSetsFrom( 0, Record{}, addSetsFrom );
+
+		std::sort( records.begin(), records.end(), []( const Record & a, const Record & b )
+		{
+			if (a.engineerSet.size() != b.engineerSet.size())
+				return a.engineerSet.size() < b.engineerSet.size();
+			return a.engineerSet < b.engineerSet;
+		});
+
+		engineerSets.clear();
+		packedGrades.assign( records.size() * bytesPerRecord + padding, 0 );
+		for (size_t idx = 0; idx < records.size(); ++idx)
+		{
+			engineerSets.push_back( records[ idx ].engineerSet );
+			for (size_t moduleIdx = 0; moduleIdx < numOfModules; ++moduleIdx)
+				packedGrades[ idx * bytesPerRecord + moduleIdx / 2 ] |= uint8_t( records[ idx ].grades[ moduleIdx ] << (4 * (moduleIdx % 2)) );
 		}
-		else
+	}
+
+	/// Stores the table in the native byte order, returns false if the file can't be written.
+	bool save( const string & fileName ) const
+	{
+		ofstream file( fileName, std::ios::binary );
+		if (!file.is_open())
+			return false;
+
+		const uint32_t version = fileVersion;
+		const uint64_t hash = databaseHash();
+		const uint64_t numOfRecords = engineerSets.size();
+		file.write( fileMagic, sizeof(fileMagic) );
+		file.write( reinterpret_cast< const char * >( &version ), sizeof(version) );
+		file.write( reinterpret_cast< const char * >( &hash ), sizeof(hash) );
+		file.write( reinterpret_cast< const char * >( &numOfRecords ), sizeof(numOfRecords) );
+		for (const EngineerSet & engineerSet : engineerSets)
 		{
-			// whole combination has been generated, evaluate it
-			if (ctx.bestSolutions.empty())
-			{
-				ctx.bestSolutions.insert( ctx.currentSolution );
-			}
-			else
-			{
-				int comparison = compare( ctx.currentSolution, *ctx.bestSolutions.begin() );
-				if (comparison == 0)  // this solution is equally good as the previous one, add it
-				{
-					ctx.bestSolutions.insert( ctx.currentSolution );
-				}
-				else if (comparison > 0)  // this solution is better than all the added ones, replace them
-				{
-					ctx.bestSolutions.clear();
-					ctx.bestSolutions.insert( ctx.currentSolution );
-				}
-			}
-			ctx.foundSolution = true;
+			const EngineerMask mask = engineerSet.mask();
+			file.write( reinterpret_cast< const char * >( &mask ), sizeof(mask) );
 		}
+		file.write( reinterpret_cast< const char * >( packedGrades.data() ), std::streamsize( packedGrades.size() - padding ) );
 
-		// restore the previous state of the set of engineers required to be unlocked
-		removeEngineerWithAllRequirements( engineerIdx, ctx.currentSolution.requiredEngineers );
-		ctx.currentSolution.relatedModifications.erase( engineerIdx, currentModCtx->mod );
+		return bool( file );
 	}
-}
 
-/// only a wrapper around the recursive function, performing required initialization
-set< Solution > findBestEngineerCombination( vector< DesiredModContext > & desiredModContexts )
+	enum class LoadResult
+	{
+		Success,
+		CantOpen,
+		InvalidFormat,
+		DifferentDatabase,
+	};
+
+	LoadResult load( const string & fileName )
+	{
+		ifstream file( fileName, std::ios::binary );
+		if (!file.is_open())
+			return LoadResult::CantOpen;
+
+		char magic [4];
+		uint32_t version = 0;
+		uint64_t hash = 0, numOfRecords = 0;
+		file.read( magic, sizeof(magic) );
+		file.read( reinterpret_cast< char * >( &version ), sizeof(version) );
+		file.read( reinterpret_cast< char * >( &hash ), sizeof(hash) );
+		file.read( reinterpret_cast< char * >( &numOfRecords ), sizeof(numOfRecords) );
+		if (!file || memcmp( magic, fileMagic, sizeof(magic) ) != 0 || version != fileVersion
+		 || numOfRecords > (uint64_t(1) << numOfEngineers))
+			return LoadResult::InvalidFormat;
+		if (hash != databaseHash())
+			return LoadResult::DifferentDatabase;
+
+		vector< EngineerMask > masks( numOfRecords );
+		packedGrades.assign( numOfRecords * bytesPerRecord + padding, 0 );
+		file.read( reinterpret_cast< char * >( masks.data() ), std::streamsize( masks.size() * sizeof(EngineerMask) ) );
+		file.read( reinterpret_cast< char * >( packedGrades.data() ), std::streamsize( packedGrades.size() - padding ) );
+		if (!file)
+			return LoadResult::InvalidFormat;
+
+		engineerSets.clear();
+		for (EngineerMask mask : masks)
+			engineerSets.push_back( EngineerSet( mask ) );
+		return LoadResult::Success;
+	}
+};
+
+/// Finds the same solutions as findBestEngineerCombination() by scanning the table, the \p mods must not be pinned.
+SolutionPool findBestEngineerCombinationInTable(
+	const ClosedSetTable & table, const vector< DesiredModContext > & mods, const Presolved & presolved
+)
 {
-	AlgorithmContext ctx;
+	SolutionPool solutions;
 
-	ctx.foundSolution = false;
+	// the highest wanted grade of each module
+	uint8_t wanted [32] = {};
+	for (const DesiredModContext & modCtx : mods)
+	{
+		size_t moduleIdx = size_t( modCtx.mod.module );
+		uint8_t shift = uint8_t( 4 * (moduleIdx % 2) );
+		uint8_t wantedGrade = std::max( uint8_t( (wanted[ moduleIdx / 2 ] >> shift) & 0xF ), uint8_t( modCtx.mod.grade ) );
+		wanted[ moduleIdx / 2 ] = uint8_t( (wanted[ moduleIdx / 2 ] & ~(0xF << shift)) | (wantedGrade << shift) );
+	}
 
-	tryAllEngineerCombinations( ctx, &desiredModContexts.front(), &desiredModContexts.back() );
+	// after the first set offering everything, only the rest of the sets of the same size need to be checked
+	size_t end = table.size();
+	for (size_t idx = table.findFirstOffering( 0, end, wanted ); idx < end; idx = table.findFirstOffering( idx + 1, end, wanted ))
+	{
+		end = table.endOfSize( table.engineers( idx ).size() );
+		EngineerSet normalized = normalizeInterchangeable( table.engineers( idx ), presolved.interchangeableGroups );
+		solutions.insert( normalized );
+	}
 
-	if (ctx.foundSolution)
-		return ctx.bestSolutions;
-	else
-		return {};  // because empty set can never be a valid result, we can use this to indicate failure
+	return solutions;
 }
 
 
@@ -586,7 +3083,7 @@ EngineerList orderTopologically( const EngineerSet & engineerSet )
 	return orderedEngineers;
 }
 
-/// simmilar to Solution, but the collection of engineers is topologically sorted
+/// a solution with the collection of engineers topologically sorted
 struct OrderedSolution
 {
 	/// engineers that need to be unlocked, in the correct unlocking order
@@ -595,20 +3092,175 @@ struct OrderedSolution
 	/// which engineer was added for which modification
 	/** Key is the engineer, value is the list of modifications for which he was choses by the algorithm. */
 	EngineerModMultimap relatedModifications;
+
+	/// engineers that can be unlocked instead of an engineer in the path, including that engineer
+	/** Empty for engineers that have no alternative. If more members of an interchangeable group are in the path,
+	  * each of them can be replaced by the members that aren't in the path, but each can be chosen only once. */
+	IndexMap< EngineerIdx, EngineerIdx::_EndOfEnum, EngineerSet > alternatives;
+
+	/// modifications that the path gives access to besides the desired ones, not counting the engineers with alternatives
+	vector< Modification > additionalModifications;
+};
+
+/// support data for assignModsToEngineers()
+struct AssignmentSearch
+{
+	const vector< DesiredMod > & mods;
+	EngineerSet engineerSet;
+
+	/// which engineers can still be required by the modifications from an index on
+	vector< EngineerSet > reachableEngineers;
+
+	/// states already known to have no valid continuation, so that they are not explored again
+	/** For each modification index, the key is the set of covered engineers and the set of pinned engineers. */
+	vector< unordered_set< uint64_t > > failedStates;
+
+	EngineerIdx * assignment;
+
+	/// chooses an engineer for the modification modIdx and continues with the next one
+	bool assignFrom( size_t modIdx, EngineerSet coveredEngineers, EngineerSet pinnedEngineers )
+	{
+		// the rest of the modifications must be able to require all the engineers not required so far
+		if (!(engineerSet - coveredEngineers - reachableEngineers[ modIdx ]).empty())
+			return false;
+		if (modIdx == mods.size())
+			return true;
+
+		const uint64_t stateKey = (uint64_t( coveredEngineers.mask() ) << 32) | pinnedEngineers.mask();
+		if (failedStates[ modIdx ].count( stateKey ) != 0)
+			return false;
+
+		EngineerSet candidates = findEngineersOfferingModification( mods[ modIdx ] ) & engineerSet;
+		if (mods[ modIdx ].pinRequired)
+			candidates = candidates - pinnedEngineers;
+
+		for (EngineerIdx engineerIdx : candidates)
+		{
+			assignment[ modIdx ] = engineerIdx;
+			EngineerSet newPinnedEngineers = pinnedEngineers;
+			if (mods[ modIdx ].pinRequired)
+				newPinnedEngineers.insert( engineerIdx );
+			if (assignFrom( modIdx + 1, coveredEngineers | requirementsOf( engineerIdx ), newPinnedEngineers ))
+				return true;
+		}
+
+		failedStates[ modIdx ].insert( stateKey );
+		return false;
+	}
 };
 
+/// Chooses which engineer of a solution will be used for which modification.
+/** The search can decide the modifications in any order and leaves out the ones that get satisfied along the way,
+  * so the assignment shown to the user is reconstructed from the final set of engineers. It's the first valid
+  * assignment when going through the modifications in the order they were entered and trying the engineers
+  * in the order of their indexes, such that the chosen engineers together require exactly the whole set.
+  * This makes the output independent of the way the search got to the solution. */
+bool assignModsToEngineers( const vector< DesiredMod > & mods, EngineerSet engineerSet, EngineerIdx * assignment )
+{
+	AssignmentSearch search { mods, engineerSet, vector< EngineerSet >( mods.size() + 1 ), {}, assignment };
+	search.failedStates.resize( mods.size() );
+
+	for (size_t modIdx = mods.size(); modIdx-- > 0;)
+	{
+		search.reachableEngineers[ modIdx ] = search.reachableEngineers[ modIdx + 1 ];
+		for (EngineerIdx engineerIdx : findEngineersOfferingModification( mods[ modIdx ] ) & engineerSet)
+			search.reachableEngineers[ modIdx ] |= requirementsOf( engineerIdx );
+	}
+
+	return search.assignFrom( 0, EngineerSet(), EngineerSet() );
+}
+
 struct Result
 {
 	/// if this is .valid(), an engineer offering this modification couldn't be found
 	Modification missingMod;
 
-	vector< OrderedSolution > possibleUnlockingPaths;
+	/// the modifications with the duplicate modules merged, the solutions are valid for these, see Presolved::mergedMods
+	vector< DesiredMod > solvedMods;
+
+	/// all the best solutions in their compact form, ordered by their sets of engineers
+	/** Solutions that differ only in the choice between interchangeable engineers are stored as one,
+	  * UnlockingPathGenerator can list them separately. */
+	SolutionPool solutions;
+
+	/// groups of engineers, of which each solution contains only the first ones, see InterchangeableEngineers
+	vector< InterchangeableEngineers > interchangeableGroups;
+
+	SearchReport report;
+
+	/// In the counting mode, the numbers of all the best solutions, of which only the first ones are in the solutions.
+	bool counted = false;
+	SolutionCount count;
+
+	bool valid() const { return !missingMod.valid() && numOfExpandedUnlockingPaths() != 0; }
+
+	size_t numOfUnlockingPaths() const { return solutions.size(); }
+
+	/// number of the unlocking paths when every choice between interchangeable engineers is counted separately
+	size_t numOfExpandedUnlockingPaths() const
+	{
+		if (counted)
+			return count.numOfEngineerSets;
+
+		size_t total = 0;
+		for (size_t idx = 0; idx < solutions.size(); ++idx)
+		{
+			size_t numOfVariants = 1;
+			for (const InterchangeableEngineers & group : interchangeableGroups)
+			{
+				// binomial coefficient: number of ways to choose the used members from the whole group
+				size_t numOfMembers = group.members.size();
+				size_t numOfUsed = (solutions.engineers( idx ) & group.members).size();
+				size_t numOfChoices = 1;
+				for (size_t i = 1; i <= numOfUsed; ++i)
+					numOfChoices = numOfChoices * (numOfMembers - numOfUsed + i) / i;
+				numOfVariants *= numOfChoices;
+			}
+			total += numOfVariants;
+		}
+		return total;
+	}
+
+	/// Constructs the full unlocking path from the compact solution, only when it's really needed.
+	bool getUnlockingPath( size_t idx, OrderedSolution & unlockingPath ) const
+	{
+		return getUnlockingPath( solutions.engineers( idx ), interchangeableGroups, unlockingPath );
+	}
+
+	/// Constructs the full unlocking path from a set of engineers, whose interchangeable \p groups are shown as alternatives.
+	/** Every solution was found for the solvedMods, so there must be an assignment requiring exactly its engineers.
+	  * Returns false if there isn't, which means an internal error. */
+	bool getUnlockingPath( EngineerSet engineerSet, const vector< InterchangeableEngineers > & groups,
+	                       OrderedSolution & unlockingPath ) const
+	{
+		unlockingPath = OrderedSolution();
+
+		// order the engineers according to their unlocking requirements
+		unlockingPath.orderedEngineers = orderTopologically( engineerSet );
+
+		vector< EngineerIdx > assignment( solvedMods.size(), EngineerIdx::None );
+		if (!assignModsToEngineers( solvedMods, engineerSet, assignment.data() ))
+			return false;
+		for (size_t modIdx = 0; modIdx < solvedMods.size(); ++modIdx)
+			if (assignment[ modIdx ] != EngineerIdx::None)
+				unlockingPath.relatedModifications.insert( assignment[ modIdx ], solvedMods[ modIdx ] );
+
+		for (const InterchangeableEngineers & group : groups)
+		{
+			EngineerSet usedMembers = engineerSet & group.members;
+			for (EngineerIdx memberIdx : usedMembers)
+			{
+				unlockingPath.alternatives[ memberIdx ] = group.members - usedMembers;
+				unlockingPath.alternatives[ memberIdx ].insert( memberIdx );
+			}
+		}
 
-	bool valid() const { return !missingMod.valid() && !possibleUnlockingPaths.empty(); }
+		return true;
+	}
 };
 
 /// Finds the shortest path through engineer unlocking that gets you access to desired modifications.
-Result findShortestEngineerUnlockingPath( const vector< DesiredMod > & desiredModifications )
+Result findShortestEngineerUnlockingPath( const vector< DesiredMod > & desiredModifications, const SearchOptions & options )
 {
 	Result result;
 
@@ -627,21 +3279,45 @@ Result findShortestEngineerUnlockingPath( const vector< DesiredMod > & desiredMo
 		}
 	}
 
-	// generate every combination of the engineers, add all their requirements, and choose the best combination
-	auto solutions = findBestEngineerCombination( desiredModContexts );
-	if (solutions.empty())
+	// make the decisions that are the same for every solution, and drop the modifications they satisfy
+	const bool keepBestSolutions = options.numOfBestSolutions != 0 && !options.countSolutions;
+	Presolved presolved = presolve( desiredModContexts, !keepBestSolutions );
+	if (presolved.infeasible)
 	{
-		return result;  // also empty
+		return result;  // empty
 	}
 
-	// order the engineers according to their unlocking requirements
-	for (const auto & solution : solutions)
+	result.solvedMods = presolved.mergedMods;
+
+	// count the solutions without keeping all of them
+	if (options.countSolutions && countBestEngineerCombinations( presolved, result.solvedMods, options.maxSolutions, result.count ))
 	{
-		result.possibleUnlockingPaths.emplace_back();
-		result.possibleUnlockingPaths.back().orderedEngineers = orderTopologically( solution.requiredEngineers);
-		result.possibleUnlockingPaths.back().relatedModifications = solution.relatedModifications;
+		result.counted = true;
+		result.solutions = SolutionPool();
+		for (EngineerSet engineerSet : result.count.firstEngineerSets)
+			result.solutions.insert( engineerSet );
+		result.count.firstEngineerSets.clear();
+		result.solutions.sort();
+		return result;
 	}
 
+	// generate every combination of the engineers, add all their requirements, and choose the best combination
+	const bool hasPinnedMods = std::any_of( desiredModifications.begin(), desiredModifications.end(),
+		[]( const DesiredMod & mod ) { return mod.pinRequired; }
+	);
+	if (keepBestSolutions)
+		result.solutions = findBestEngineerCombination( presolved, options, result.report );  // only it can keep k best
+	else if (options.engine == SearchEngine::ClosedSetTable && options.closedSetTable && !hasPinnedMods)
+		result.solutions = findBestEngineerCombinationInTable( *options.closedSetTable, desiredModContexts, presolved );
+	else if (options.engine == SearchEngine::TreeDP)
+		result.solutions = findBestEngineerCombinationByTreeDP( presolved, options, result.report );
+	else if (options.engine == SearchEngine::MeetInTheMiddle)
+		result.solutions = findBestEngineerCombinationByMeetInTheMiddle( presolved, options, result.report );
+	else
+		result.solutions = findBestEngineerCombination( presolved, options, result.report );
+	result.solutions.sort();
+	result.interchangeableGroups = move( presolved.interchangeableGroups );
+
 	return result;
 }
 
@@ -656,48 +3332,175 @@ vector< Modification > getAdditionalModifications(
 {
 	vector< Modification > additionalMods;
 
-	unordered_map< ModuleType, grade_t > offeredMods;  // table: module -> grade
+	const SimdKernels & kernels = simdKernels();
 
-	// add all modifications of all required engineers
+	// add all modifications of all required engineers, the first engineer offering a module decides its grade
+	uint8_t offeredMods [ gradeVectorSize ] = {};
 	for (EngineerIdx engineerIdx : unlockedEngineers)
 	{
-		for (const auto & mod : engineers[ engineerIdx ].modifications)
-		{
-			offeredMods.insert({ mod.module, mod.grade });
-		}
+		kernels.mergeFirstOffers( offeredMods, offeredGradeVectors[ engineerIdx ] );
 	}
 
 	// now remove all the modifications that the player already wanted
+	uint8_t wantedMods [ gradeVectorSize ] = {};
 	for (const auto & desiredMod : desiredMods)
 	{
-		auto modIter = offeredMods.find( desiredMod.module );
-		if (modIter != offeredMods.end())
+		uint8_t & wantedGrade = wantedMods[ size_t(desiredMod.module) ];
+		wantedGrade = std::max( wantedGrade, uint8_t( desiredMod.grade ) );
+	}
+
+	// the bits are ordered by the modules, so the result is sorted already
+	for (uint64_t modules = kernels.modulesExceeding( offeredMods, wantedMods ); modules != 0; modules &= modules - 1)
+	{
+		size_t moduleIdx = countTrailingZeros( modules );
+		additionalMods.push_back({ grade_t( offeredMods[ moduleIdx ] ), ModuleType( moduleIdx ) });
+	}
+
+	return additionalMods;
+}
+
+
+/// Pull iterator over the unlocking paths of a Result, in the order of their sets of engineers.
+/** Each path is constructed, ordered and completed with its additional modifications only when it's asked for,
+  * so the time to the first path and the memory don't depend on how many paths there are.
+  * When the interchangeable engineers are expanded, every solution generates its variants one by one in the order
+  * of their engineer sets, and a heap merges them with the variants of the other solutions. */
+class UnlockingPathGenerator
+{
+	const Result & result;
+	bool expandInterchangeable;
+
+	size_t nextSolutionIdx = 0;
+
+	/// the set of engineers whose unlocking path couldn't be constructed, valid when failed is set
+	EngineerSet failedEngineerSet;
+	bool failed = false;
+
+	/// the smallest variant of each solution that wasn't generated yet, the greatest on the top of the heap
+	struct Variant
+	{
+		EngineerSet engineers;
+		size_t solutionIdx;
+
+		bool operator<( const Variant & other ) const  { return SmallerEngineerSet()( other.engineers, engineers ); }
+	};
+	vector< Variant > variantHeap;
+
+	/// Chooses the first members of each interchangeable group, which gives the smallest variant of a solution.
+	EngineerSet firstVariant( EngineerSet engineerSet ) const
+	{
+		for (const InterchangeableEngineers & group : result.interchangeableGroups)
+		{
+			size_t numOfUsed = (engineerSet & group.members).size();
+			engineerSet = engineerSet - group.members;
+			for (auto memberIter = group.members.begin(); numOfUsed > 0; ++memberIter, --numOfUsed)
+				engineerSet.insert( *memberIter );
+		}
+		return engineerSet;
+	}
+
+	/// Finds the variant of the same solution that follows right after \p variant, returns false if it's the last one.
+	/** The variants are the leaves of a search that decides the members of all the groups in the order of their indexes,
+	  * trying each member included first, because that gives the smaller set. So the next one is found by excluding
+	  * the last included member that can be excluded, and completing the rest with the first possible members. */
+	bool nextVariant( EngineerSet & variant ) const
+	{
+		EngineerSet choosable;
+		for (const InterchangeableEngineers & group : result.interchangeableGroups)
+			choosable |= group.members;
+
+		// go from the highest included member down
+		for (size_t idx = size_t( lastEngineerIdx ); idx >= size_t( firstEngineerIdx ); --idx)
 		{
-			if (modIter->second <= desiredMod.grade)
+			const EngineerIdx memberIdx = EngineerIdx( idx );
+			if (!(variant & choosable).contains( memberIdx ))
+				continue;
+
+			const InterchangeableEngineers & group = *findSuch( result.interchangeableGroups,
+				[ memberIdx ]( const InterchangeableEngineers & group ) { return group.members.contains( memberIdx ); }
+			);
+			const EngineerSet below( (EngineerMask(1) << memberIdx) - 1 );
+			const EngineerSet above = EngineerSet( ~(below.mask() | (EngineerMask(1) << memberIdx)) );
+			const size_t numOfNeeded = (variant & group.members & above).size() + 1;
+			if ((group.members & above).size() < numOfNeeded)
+				continue;  // the group would not have enough members left
+
+			// keep everything below, and fill the groups with their first members above
+			EngineerSet next = (variant - choosable) | (variant & choosable & below);
+			for (const InterchangeableEngineers & otherGroup : result.interchangeableGroups)
 			{
-				offeredMods.erase( modIter );
+				size_t numOfMissing = (variant & otherGroup.members).size() - (next & otherGroup.members).size();
+				for (auto iter = (otherGroup.members & above).begin(); numOfMissing > 0; ++iter, --numOfMissing)
+					next.insert( *iter );
 			}
+			variant = next;
+			return true;
 		}
+		return false;
 	}
 
-	additionalMods.reserve( offeredMods.size() );
-	for (auto [module, grade] : offeredMods)
+ public:
+
+	UnlockingPathGenerator( const Result & result, bool expandInterchangeable )
+		: result( result ), expandInterchangeable( expandInterchangeable && !result.interchangeableGroups.empty() )
 	{
-		additionalMods.push_back({ grade, module });
+		if (this->expandInterchangeable)
+		{
+			for (size_t idx = 0; idx < result.solutions.size(); ++idx)
+				variantHeap.push_back({ firstVariant( result.solutions.engineers( idx ) ), idx });
+			std::make_heap( variantHeap.begin(), variantHeap.end() );
+		}
 	}
 
-	std::sort( additionalMods.begin(), additionalMods.end(),
-		[]( const Modification & a, const Modification & b ) -> bool
+	/// Constructs the next unlocking path, returns false when there are no more, or when it couldn't be constructed.
+	bool next( OrderedSolution & unlockingPath )
+	{
+		if (expandInterchangeable)
 		{
-			if (a.module != b.module)
-				return a.module < b.module;
+			if (variantHeap.empty())
+				return false;
+
+			std::pop_heap( variantHeap.begin(), variantHeap.end() );
+			Variant & variant = variantHeap.back();
+			if (!result.getUnlockingPath( variant.engineers, {}, unlockingPath ))
+			{
+				failedEngineerSet = variant.engineers;
+				failed = true;
+				return false;
+			}
+			if (nextVariant( variant.engineers ))
+				std::push_heap( variantHeap.begin(), variantHeap.end() );
 			else
-				return a.grade < b.grade;
+				variantHeap.pop_back();
 		}
-	);
+		else
+		{
+			if (nextSolutionIdx == result.solutions.size())
+				return false;
 
-	return additionalMods;
-}
+			if (!result.getUnlockingPath( nextSolutionIdx, unlockingPath ))
+			{
+				failedEngineerSet = result.solutions.engineers( nextSolutionIdx );
+				failed = true;
+				return false;
+			}
+			++nextSolutionIdx;
+		}
+
+		// what the interchangeable engineers offer in addition depends on which of them is chosen
+		EngineerList certainEngineers;
+		for (EngineerIdx engineerIdx : unlockingPath.orderedEngineers)
+			if (unlockingPath.alternatives[ engineerIdx ].empty())
+				certainEngineers.push_back( engineerIdx );
+		unlockingPath.additionalModifications = getAdditionalModifications( result.solvedMods, certainEngineers );
+
+		return true;
+	}
+
+	/// whether next() stopped because the unlocking path of failedSolution() couldn't be constructed
+	bool hasFailed() const  { return failed; }
+	EngineerSet failedSolution() const  { return failedEngineerSet; }
+};
 
 
 //======================================================================================================================
@@ -819,11 +3622,31 @@ void printList( const List & list )
 	}
 }
 
+/// Name of the engineer in the unlocking path, together with the engineers that can be unlocked instead of him.
+string engineerChoiceToString( const OrderedSolution & unlockingPath, EngineerIdx engineerIdx )
+{
+	const EngineerSet & alternatives = unlockingPath.alternatives[ engineerIdx ];
+	if (alternatives.empty())
+		return engineerToString( engineerIdx );
+
+	string choice;
+	for (EngineerIdx alternativeIdx : alternatives)
+	{
+		if (!choice.empty())
+			choice += " | ";
+		choice += engineerToString( alternativeIdx );
+	}
+	return choice;
+}
+
 void printEngineerUnlockingPath( const OrderedSolution & unlockingPath, uint indentation = 0 )
 {
 	for (EngineerIdx engineerIdx : unlockingPath.orderedEngineers)
 	{
-		cout << indent( indentation ) << std::left << std::setw( 18 ) << engineerToString( engineerIdx );
+		string engineerChoice = engineerChoiceToString( unlockingPath, engineerIdx );
+		cout << indent( indentation ) << std::left << std::setw( 18 ) << engineerChoice;
+		if (engineerChoice.size() >= 18)
+			cout << "  ";
 		// print all of the related modifications
 
 		if (!unlockingPath.relatedModifications[ engineerIdx ].empty())
@@ -849,7 +3672,7 @@ void printDetailedUnlockingPath( const vector< DesiredMod > & desiredMods, const
 {
 	for (EngineerIdx engineerIdx : unlockingPath.orderedEngineers)
 	{
-		cout << engineerToString( engineerIdx ) << ":\n";
+		cout << engineerChoiceToString( unlockingPath, engineerIdx ) << ":\n";
 		for (const auto & offeredMod : engineers[ size_t(engineerIdx) ].modifications)
 		{
 			const auto & relatedModsOfEngineer = unlockingPath.relatedModifications[ engineerIdx ];
@@ -888,6 +3711,11 @@ struct Args
 {
 	string fileName;
 	bool detailedOutput = false;
+	bool expandInterchangeable = false;
+	SearchOptions searchOptions;
+	string tableFileName;  ///< the table of closed engineer sets to use for the search
+	string newTableFileName;  ///< where to store the table of closed engineer sets, instead of doing a search
+	string resumeFileName;  ///< the checkpoint of a previous search to continue from
 	bool invalid = false;
 };
 
@@ -901,6 +3729,75 @@ Args parseArgs( int argc, char * argv [] )
 		{
 			args.detailedOutput = true;
 		}
+		else if (strcmp( argv[i], "--expand" ) == 0)
+		{
+			args.expandInterchangeable = true;
+		}
+		else if (strcmp( argv[i], "--dynamic-order" ) == 0)
+		{
+			args.searchOptions.dynamicOrdering = true;
+		}
+		else if (strcmp( argv[i], "--engine" ) == 0 && i + 1 < argc)
+		{
+			++i;
+			if (strcmp( argv[i], "dfs" ) == 0)
+				args.searchOptions.engine = SearchEngine::DepthFirst;
+			else if (strcmp( argv[i], "tree-dp" ) == 0)
+				args.searchOptions.engine = SearchEngine::TreeDP;
+			else if (strcmp( argv[i], "mitm" ) == 0)
+				args.searchOptions.engine = SearchEngine::MeetInTheMiddle;
+			else
+			{
+				cerr << "unknown engine: " << argv[i] << " (must be: dfs, tree-dp, mitm)" << endl;
+				args.invalid = true;
+			}
+		}
+		else if (strcmp( argv[i], "--table" ) == 0 && i + 1 < argc)
+		{
+			args.tableFileName = argv[++i];
+			args.searchOptions.engine = SearchEngine::ClosedSetTable;
+		}
+		else if (strcmp( argv[i], "--build-table" ) == 0 && i + 1 < argc)
+		{
+			args.newTableFileName = argv[++i];
+		}
+		else if (strcmp( argv[i], "--threads" ) == 0 && i + 1 < argc)
+		{
+			args.searchOptions.numOfThreads = uint( std::max( atoi( argv[++i] ), 1 ) );
+		}
+		else if (strcmp( argv[i], "--time-budget" ) == 0 && i + 1 < argc)
+		{
+			args.searchOptions.timeBudget = std::chrono::milliseconds( strtoull( argv[++i], nullptr, 10 ) );
+		}
+		else if (strcmp( argv[i], "--checkpoint" ) == 0 && i + 1 < argc)
+		{
+			args.searchOptions.checkpointFileName = argv[++i];
+		}
+		else if (strcmp( argv[i], "--checkpoint-interval" ) == 0 && i + 1 < argc)
+		{
+			args.searchOptions.checkpointInterval = std::chrono::seconds( strtoull( argv[++i], nullptr, 10 ) );
+		}
+		else if (strcmp( argv[i], "--resume" ) == 0 && i + 1 < argc)
+		{
+			args.resumeFileName = argv[++i];
+		}
+		else if (strcmp( argv[i], "--count" ) == 0)
+		{
+			args.searchOptions.countSolutions = true;
+		}
+		else if (strcmp( argv[i], "--max-solutions" ) == 0 && i + 1 < argc)
+		{
+			args.searchOptions.countSolutions = true;
+			args.searchOptions.maxSolutions = size_t( strtoull( argv[++i], nullptr, 10 ) );
+		}
+		else if (strcmp( argv[i], "--top" ) == 0 && i + 1 < argc)
+		{
+			args.searchOptions.numOfBestSolutions = size_t( strtoull( argv[++i], nullptr, 10 ) );
+		}
+		else if (strcmp( argv[i], "--memory-limit" ) == 0 && i + 1 < argc)
+		{
+			args.searchOptions.memoryLimit = size_t( strtoull( argv[++i], nullptr, 10 ) ) << 20;
+		}
 		else if (strncmp( argv[i], "--", 2 ) == 0)
 		{
 			cerr << "unknown option: " << argv[i] << endl;
@@ -933,10 +3830,68 @@ int main( int argc, char * argv [] )
 	Args args = parseArgs( argc, argv );
 	if (args.invalid)
 	{
-		cout << "usage: " << argv[0] << " [--detailed] <file_name>";
+		const string padding( strlen( argv[0] ), ' ' );
+		cout << "usage: " << argv[0] << " [--detailed] [--expand] [--dynamic-order] [--engine dfs|tree-dp|mitm] [--memory-limit <MiB>]\n"
+		     << "       " << padding << " [--threads <N>] [--time-budget <ms>] [--checkpoint <file> [--checkpoint-interval <s>]]\n"
+		     << "       " << padding << " [--resume <file>] [--count] [--max-solutions <N>] [--top <K>]\n"
+		     << "       " << padding << " [--table <table_file>] <file_name>\n"
+		     << "       " << argv[0] << " --build-table <table_file>";
 		return 1;
 	}
 
+	if (!args.newTableFileName.empty())
+	{
+		ClosedSetTable table;
+		table.build();
+		if (!table.save( args.newTableFileName ))
+		{
+			cerr << "Can't write file " << args.newTableFileName << " (" << strerror(errno) << ")" << endl;
+			return 2;
+		}
+		cout << "Stored " << table.size() << " engineer sets to " << args.newTableFileName << endl;
+		return 0;
+	}
+
+	ClosedSetTable table;
+	if (!args.tableFileName.empty())
+	{
+		switch (table.load( args.tableFileName ))
+		{
+			case ClosedSetTable::LoadResult::Success:
+				args.searchOptions.closedSetTable = &table;
+				break;
+			case ClosedSetTable::LoadResult::CantOpen:
+				cerr << "Can't open file " << args.tableFileName << " (" << strerror(errno) << ")" << endl;
+				return 2;
+			case ClosedSetTable::LoadResult::InvalidFormat:
+				cerr << "File " << args.tableFileName << " is not a valid table of engineer sets" << endl;
+				return 2;
+			case ClosedSetTable::LoadResult::DifferentDatabase:
+				cerr << "The table in " << args.tableFileName << " was built for different engineers, build it again" << endl;
+				return 2;
+		}
+	}
+
+	// the resumed search continues storing its checkpoints to the same file, unless told otherwise
+	SearchCheckpoint checkpoint;
+	if (!args.resumeFileName.empty())
+	{
+		switch (checkpoint.load( args.resumeFileName ))
+		{
+			case SearchCheckpoint::LoadResult::Success:
+				args.searchOptions.resumeFrom = &checkpoint;
+				if (args.searchOptions.checkpointFileName.empty())
+					args.searchOptions.checkpointFileName = args.resumeFileName;
+				break;
+			case SearchCheckpoint::LoadResult::CantOpen:
+				cerr << "Can't open file " << args.resumeFileName << " (" << strerror(errno) << ")" << endl;
+				return 2;
+			case SearchCheckpoint::LoadResult::InvalidFormat:
+				cerr << "File " << args.resumeFileName << " is not a valid search checkpoint" << endl;
+				return 2;
+		}
+	}
+
 	const bool interactive = args.fileName.empty();
 
 	vector< DesiredMod > desiredMods;
@@ -967,15 +3922,27 @@ int main( int argc, char * argv [] )
 		return 3;
 	}
 
-	auto result = findShortestEngineerUnlockingPath( desiredMods );
+	auto result = findShortestEngineerUnlockingPath( desiredMods, args.searchOptions );
 
-	if (result.missingMod.valid())
+	if (result.report.checkpointMismatch)
+	{
+		cerr << "The checkpoint in " << args.resumeFileName << " was made for different modifications or options" << endl;
+		if (interactive) waitForEnter();
+		return 2;
+	}
+	else if (result.missingMod.valid())
 	{
 		cerr << "There is no engineer that offers modification: " << result.missingMod << endl;
 		if (interactive) waitForEnter();
 		return 3;
 	}
-	else if (result.possibleUnlockingPaths.empty())
+	else if (!result.valid() && result.report.timeBudgetExceeded)
+	{
+		cerr << "No unlocking path was found within the time budget." << endl;
+		if (interactive) waitForEnter();
+		return 4;
+	}
+	else if (!result.valid())
 	{
 		cerr << "The input requirements couldn't be satisfied,\n"
 		     << "there is not enough engineers to cover all your desired modifications." << endl;
@@ -983,10 +3950,60 @@ int main( int argc, char * argv [] )
 		return 4;
 	}
 
-	cout << "There are " << result.possibleUnlockingPaths.size() << " possible unlocking paths." << endl;
-	for (uint idx = 0; idx < result.possibleUnlockingPaths.size(); ++idx)
+	if (args.searchOptions.engine == SearchEngine::MeetInTheMiddle)
+	{
+		cerr << "Meet-in-the-middle tables: " << result.report.numOfStoredStates << " states, about "
+		     << (result.report.memoryUsed >> 10) << " KiB" << endl;
+		if (result.report.memoryLimitExceeded)
+			cerr << "The memory limit was exceeded, the depth-first search was used instead." << endl;
+	}
+
+	if (!args.searchOptions.checkpointFileName.empty())
+	{
+		cerr << "Explored " << result.report.numOfExploredStates << " search states in total";
+		if (result.report.checkpointSaveFailed)
+			cerr << ", but the checkpoint couldn't be written to " << args.searchOptions.checkpointFileName;
+		cerr << endl;
+	}
+
+	// list the paths with interchangeable engineers separately only on demand, there can be very many of them
+	const size_t numOfExpandedPaths = result.numOfExpandedUnlockingPaths();
+	const size_t numOfShownPaths = args.expandInterchangeable && !result.counted ? numOfExpandedPaths : result.numOfUnlockingPaths();
+
+	if (args.searchOptions.countSolutions && !result.counted)
+		cerr << "There are too many modifications for counting, all the paths are listed instead." << endl;
+
+	if (args.searchOptions.numOfBestSolutions != 0 && !result.counted)
+		cout << "These are the " << numOfExpandedPaths << " shortest unlocking paths";
+	else
+		cout << "There are " << numOfExpandedPaths << " possible unlocking paths";
+	if (result.counted && numOfShownPaths != numOfExpandedPaths)
+		cout << " (showing the first " << numOfShownPaths << ")";
+	else if (numOfShownPaths != numOfExpandedPaths)
+		cout << " (shown as " << numOfShownPaths << " with interchangeable engineers grouped together)";
+	cout << "." << endl;
+	if (result.counted)
+	{
+		cout << "They have " << (result.count.numOfAssignments == UINT64_MAX ? "at least " : "") << result.count.numOfAssignments
+		     << " different assignments of the modifications to the engineers." << endl;
+	}
+	if (result.report.timeBudgetExceeded)
+	{
+		const uint foundSize = uint( result.solutions.engineers( 0 ).size() );
+		const uint lowerBound = std::min( foundSize, result.report.lowerBound );
+		cout << "The time budget ran out before the search could prove that these paths are the shortest.\n"
+		     << "They need " << foundSize << " engineers, the shortest ones need at least " << lowerBound
+		     << " (gap of " << foundSize - lowerBound << ")." << endl;
+	}
+	else if (args.searchOptions.timeBudget.count() != 0)
+	{
+		cout << "The search finished within the time budget, these paths are the shortest." << endl;
+	}
+
+	UnlockingPathGenerator unlockingPaths( result, args.expandInterchangeable );
+	OrderedSolution possiblePath;
+	for (size_t idx = 0; unlockingPaths.next( possiblePath ); ++idx)
 	{
-		const auto & possiblePath = result.possibleUnlockingPaths[ idx ];
 		if (args.detailedOutput)
 		{
 			cout << '\n' << '\n';
@@ -1003,17 +4020,36 @@ int main( int argc, char * argv [] )
 			printEngineerUnlockingPath( possiblePath, 1 );
 			cout << endl;
 
-			auto additionalMods = getAdditionalModifications( desiredMods, possiblePath.orderedEngineers );
-			cout << "Additionally you will get access to:\n";
-			printModifications( additionalMods, 1 );
+			const bool hasAlternatives = containsSuch( possiblePath.orderedEngineers, [ &possiblePath ]( EngineerIdx engineerIdx )
+			{
+				return !possiblePath.alternatives[ engineerIdx ].empty();
+			});
+			if (hasAlternatives)
+				cout << "Additionally you will get access to (not counting the interchangeable engineers):\n";
+			else
+				cout << "Additionally you will get access to:\n";
+			printModifications( possiblePath.additionalModifications, 1 );
 			cout << endl;
 		}
 
-		if (idx < result.possibleUnlockingPaths.size() - 1)
+		if (idx < numOfShownPaths - 1)
 		{
 			cout << "\nPress enter to show next possible path." << endl;
 			waitForEnter();
 		}
 	}
+	if (unlockingPaths.hasFailed())
+	{
+		cerr << "Internal error: the desired modifications can't be assigned to the engineers of a found path:";
+		const char * separator = " ";
+		for (EngineerIdx engineerIdx : unlockingPaths.failedSolution())
+		{
+			cerr << separator << engineerToString( engineerIdx );
+			separator = ", ";
+		}
+		cerr << endl;
+		if (interactive) waitForEnter();
+		return 5;
+	}
 	return 0;
 }
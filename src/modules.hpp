@@ -123,13 +123,15 @@ static_assert( size_t(ModuleType::_EndOfEnum) == std::size(ModuleTypeStr), "stri
 
 using grade_t = ushort;
 
+static constexpr grade_t maxGrade = 5;
+
 struct Modification
 {
 	grade_t grade;
 	ModuleType module;
 
-	Modification() : grade(0) {}
-	Modification( grade_t g, ModuleType m ) : grade(g), module(m) {}
+	constexpr Modification() : grade(0), module( firstModule ) {}
+	constexpr Modification( grade_t g, ModuleType m ) : grade(g), module(m) {}
 
 	bool valid() const { return grade != 0; }  // used for indicating errors
 